@@ -38,9 +38,6 @@
 **  Constants
 *****************************************************************************/
 
-/* maximum length of data to read from RFCOMM */
-#define BTA_AG_RFC_READ_MAX     512
-
 /* maximum AT command length */
 #define BTA_AG_CMD_MAX          512
 
@@ -647,31 +644,29 @@ void bta_ag_rfc_acp_open(tBTA_AG_SCB *p_scb, tBTA_AG_DATA *p_data)
 *******************************************************************************/
 void bta_ag_rfc_data(tBTA_AG_SCB *p_scb, tBTA_AG_DATA *p_data)
 {
-    UINT16  len;
-    char    buf[BTA_AG_RFC_READ_MAX];
+    BT_HDR  *p_buf;
     UNUSED(p_data);
 
-    memset(buf, 0, BTA_AG_RFC_READ_MAX);
-
     APPL_TRACE_DEBUG ("bta_ag_rfc_data");
     /* do the following */
     for(;;)
     {
-        /* read data from rfcomm; if bad status, we're done */
-        if (PORT_ReadData(p_scb->conn_handle, buf, BTA_AG_RFC_READ_MAX, &len) != PORT_SUCCESS)
+        /* take the received buffers from rfcomm; if bad status, we're done */
+        if (PORT_Read(p_scb->conn_handle, &p_buf) != PORT_SUCCESS)
         {
             break;
         }
 
         /* if no data, we're done */
-        if (len == 0)
+        if (p_buf == NULL)
         {
             break;
         }
 
-        /* run AT command interpreter on data */
+        /* run AT command interpreter on data, in place */
         bta_sys_busy(BTA_ID_AG, p_scb->app_id, p_scb->peer_addr);
-        bta_ag_at_parse(&p_scb->at_cb, buf, len);
+        bta_ag_at_parse(&p_scb->at_cb, (char *)(p_buf + 1) + p_buf->offset, p_buf->len);
+        GKI_freebuf(p_buf);
         if ((p_scb->sco_idx != BTM_INVALID_SCO_INDEX) && bta_ag_sco_is_open(p_scb))
         {
             APPL_TRACE_DEBUG ("bta_ag_rfc_data, change link policy for SCO");
@@ -681,11 +676,6 @@ void bta_ag_rfc_data(tBTA_AG_SCB *p_scb, tBTA_AG_DATA *p_data)
         {
             bta_sys_idle(BTA_ID_AG, p_scb->app_id, p_scb->peer_addr);
         }
-        /* no more data to read, we're done */
-        if (len < BTA_AG_RFC_READ_MAX)
-        {
-            break;
-        }
     }
 }
 
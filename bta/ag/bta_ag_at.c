@@ -31,11 +31,107 @@
 **  Constants
 *****************************************************************************/
 
+#define BTA_AG_AT_HASH_MASK     (BTA_AG_AT_HASH_SIZE - 1)
+
+/* command line terminators */
+#define BTA_AG_AT_IS_TERM(c)    ((c) == '\r' || (c) == '\n' || (c) == 0x1A || (c) == 0x1B)
+
+/******************************************************************************
+**
+** Function         bta_ag_at_name_len
+**
+** Description      Length of the command name at the start of p: a basic
+**                  command is one character, an extended command is '+'
+**                  followed by letters and digits.
+**
+**
+** Returns          name length
+**
+******************************************************************************/
+static UINT16 bta_ag_at_name_len(const char *p)
+{
+    const char *p_start = p;
+
+    if (*p++ != '+')
+        return (p_start[0] != 0) ? 1 : 0;
+
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9'))
+        p++;
+
+    return (UINT16)(p - p_start);
+}
+
+/******************************************************************************
+**
+** Function         bta_ag_at_hash
+**
+** Description      Case insensitive hash of a command name.
+**
+**
+** Returns          hash table slot
+**
+******************************************************************************/
+static UINT16 bta_ag_at_hash(const char *p, UINT16 len)
+{
+    UINT16 h = 0;
+    char c;
+
+    while (len--)
+    {
+        c = *p++;
+        if (c >= 'a' && c <= 'z')
+            c -= 0x20;
+        h = (h * 31) + (UINT8) c;
+    }
+    return (h & BTA_AG_AT_HASH_MASK);
+}
+
+/******************************************************************************
+**
+** Function         bta_ag_at_lookup
+**
+** Description      Find the command whose name is the name at the start of
+**                  p_cmd.  Commands which only match as a prefix of a longer
+**                  name are found by a scan of the table, as before.
+**
+**
+** Returns          index in the command table, index of the terminating
+**                  empty entry if none matches
+**
+******************************************************************************/
+static UINT16 bta_ag_at_lookup(tBTA_AG_AT_CB *p_cb, const char *p_cmd)
+{
+    UINT16 len = bta_ag_at_name_len(p_cmd);
+    UINT16 slot = bta_ag_at_hash(p_cmd, len);
+    UINT16 idx;
+
+    while (p_cb->hash[slot] != 0)
+    {
+        idx = p_cb->hash[slot] - 1;
+        if (p_cb->p_at_tbl[idx].p_cmd[len] == 0 &&
+            !utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cmd))
+        {
+            return idx;
+        }
+        slot = (slot + 1) & BTA_AG_AT_HASH_MASK;
+    }
+
+    for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++)
+    {
+        if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cmd))
+        {
+            break;
+        }
+    }
+    return idx;
+}
+
 /******************************************************************************
 **
 ** Function         bta_ag_at_init
 **
-** Description      Initialize the AT command parser control block.
+** Description      Initialize the AT command parser control block.  The
+**                  command table must be set.
 **
 **
 ** Returns          void
@@ -43,8 +139,28 @@
 ******************************************************************************/
 void bta_ag_at_init(tBTA_AG_AT_CB *p_cb)
 {
+    UINT16 idx, slot, len;
+
     p_cb->p_cmd_buf = NULL;
     p_cb->cmd_pos = 0;
+
+    /* index the command table; a name only reached as the prefix of an
+       earlier one keeps being found by the table scan */
+    memset(p_cb->hash, 0, sizeof(p_cb->hash));
+    for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0 && idx < BTA_AG_AT_HASH_SIZE - 1; idx++)
+    {
+        len = (UINT16) strlen(p_cb->p_at_tbl[idx].p_cmd);
+        if (bta_ag_at_name_len(p_cb->p_at_tbl[idx].p_cmd) != len ||
+            bta_ag_at_lookup(p_cb, p_cb->p_at_tbl[idx].p_cmd) != idx)
+        {
+            continue;
+        }
+
+        slot = bta_ag_at_hash(p_cb->p_at_tbl[idx].p_cmd, len);
+        while (p_cb->hash[slot] != 0)
+            slot = (slot + 1) & BTA_AG_AT_HASH_MASK;
+        p_cb->hash[slot] = (UINT8)(idx + 1);
+    }
 }
 
 /******************************************************************************
@@ -86,14 +202,8 @@ void bta_ag_process_at(tBTA_AG_AT_CB *p_cb)
     UINT8       arg_type;
     char        *p_arg;
     INT16       int_arg = 0;
-    /* loop through at command table looking for match */
-    for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++)
-    {
-        if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf))
-        {
-            break;
-        }
-    }
+
+    idx = bta_ag_at_lookup(p_cb, p_cb->p_cmd_buf);
 
     /* if there is a match; verify argument type */
     if (p_cb->p_at_tbl[idx].p_cmd[0] != 0)
@@ -187,8 +297,10 @@ void bta_ag_process_at(tBTA_AG_AT_CB *p_cb)
 ******************************************************************************/
 void bta_ag_at_parse(tBTA_AG_AT_CB *p_cb, char *p_buf, UINT16 len)
 {
-    int i = 0;
-    char* p_save;
+    char    *p_end = p_buf + len;
+    char    *p;
+    char    *p_save;
+    UINT16  n;
 
     if (p_cb->p_cmd_buf == NULL)
     {
@@ -196,48 +308,57 @@ void bta_ag_at_parse(tBTA_AG_AT_CB *p_cb, char *p_buf, UINT16 len)
         p_cb->cmd_pos = 0;
     }
 
-    for (i = 0; i < len;)
+    while (p_buf < p_end)
     {
-        while (p_cb->cmd_pos < p_cb->cmd_max_len-1 && i < len)
+        /* Skip null characters between AT commands. */
+        if ((p_cb->cmd_pos == 0) && (*p_buf == 0))
         {
-            /* Skip null characters between AT commands. */
-            if ((p_cb->cmd_pos == 0) && (p_buf[i] == 0))
-            {
-                i++;
-                continue;
-            }
+            p_buf++;
+            continue;
+        }
 
-            p_cb->p_cmd_buf[p_cb->cmd_pos] = p_buf[i++];
-            if ( p_cb->p_cmd_buf[p_cb->cmd_pos] == '\r' || p_cb->p_cmd_buf[p_cb->cmd_pos] == '\n')
-            {
-                p_cb->p_cmd_buf[p_cb->cmd_pos] = 0;
-                if ((p_cb->cmd_pos > 2)                                      &&
-                    (p_cb->p_cmd_buf[0] == 'A' || p_cb->p_cmd_buf[0] == 'a') &&
-                    (p_cb->p_cmd_buf[1] == 'T' || p_cb->p_cmd_buf[1] == 't'))
-                {
-                    p_save = p_cb->p_cmd_buf;
-                    p_cb->p_cmd_buf += 2;
-                    bta_ag_process_at(p_cb);
-                    p_cb->p_cmd_buf = p_save;
-                }
+        /* copy up to the next terminator at once */
+        for (p = p_buf; p < p_end && !BTA_AG_AT_IS_TERM(*p); p++)
+            ;
+        n = (UINT16)(p - p_buf);
+        if (n > p_cb->cmd_max_len - 1 - p_cb->cmd_pos)
+            n = p_cb->cmd_max_len - 1 - p_cb->cmd_pos;
+        memcpy(p_cb->p_cmd_buf + p_cb->cmd_pos, p_buf, n);
+        p_cb->cmd_pos += n;
+        p_buf += n;
 
+        /* command too long; discard it, the rest starts a new command */
+        if (p_cb->cmd_pos == p_cb->cmd_max_len - 1)
+        {
+            if (p_buf < p_end)
                 p_cb->cmd_pos = 0;
+            continue;
+        }
 
-            }
-            else if( p_cb->p_cmd_buf[p_cb->cmd_pos] == 0x1A || p_cb->p_cmd_buf[p_cb->cmd_pos] == 0x1B )
-            {
-                p_cb->p_cmd_buf[++p_cb->cmd_pos] = 0;
-                (*p_cb->p_err_cback)(p_cb->p_user, TRUE, p_cb->p_cmd_buf);
-                p_cb->cmd_pos = 0;
-            }
-            else
+        if (p_buf == p_end)
+            break;
+
+        if (*p_buf == '\r' || *p_buf == '\n')
+        {
+            p_cb->p_cmd_buf[p_cb->cmd_pos] = 0;
+            if ((p_cb->cmd_pos > 2)                                      &&
+                (p_cb->p_cmd_buf[0] == 'A' || p_cb->p_cmd_buf[0] == 'a') &&
+                (p_cb->p_cmd_buf[1] == 'T' || p_cb->p_cmd_buf[1] == 't'))
             {
-                ++p_cb->cmd_pos;
+                p_save = p_cb->p_cmd_buf;
+                p_cb->p_cmd_buf += 2;
+                bta_ag_process_at(p_cb);
+                p_cb->p_cmd_buf = p_save;
             }
         }
-
-        if (i < len)
-            p_cb->cmd_pos = 0;
+        else
+        {
+            /* 0x1A or 0x1B */
+            p_cb->p_cmd_buf[p_cb->cmd_pos] = *p_buf;
+            p_cb->p_cmd_buf[++p_cb->cmd_pos] = 0;
+            (*p_cb->p_err_cback)(p_cb->p_user, TRUE, p_cb->p_cmd_buf);
+        }
+        p_cb->cmd_pos = 0;
+        p_buf++;
     }
 }
-
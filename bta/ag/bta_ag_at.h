@@ -39,6 +39,9 @@
 #define BTA_AG_AT_STR           0           /* string */
 #define BTA_AG_AT_INT           1           /* integer */
 
+/* Slots of the command lookup table, a power of 2 larger than any command table */
+#define BTA_AG_AT_HASH_SIZE     64
+
 /*****************************************************************************
 **  Data types
 *****************************************************************************/
@@ -71,6 +74,7 @@ typedef struct
     UINT16                  cmd_pos;        /* position in temp buffer */
     UINT16                  cmd_max_len;    /* length of temp buffer to allocate */
     UINT8                   state;          /* parsing state */
+    UINT8                   hash[BTA_AG_AT_HASH_SIZE]; /* command index + 1, 0 if free */
 } tBTA_AG_AT_CB;
 
 /*****************************************************************************
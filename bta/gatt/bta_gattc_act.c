@@ -1033,6 +1033,7 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
                 GKI_freebuf (GKI_dequeue (&p_clcb->p_srcb->cache_buffer));
             }
             p_clcb->p_srcb->p_srvc_cache = NULL;
+            p_clcb->p_srcb->notif_handle = 0;
         }
 
         /* used to reset cache in application */
@@ -1920,6 +1921,7 @@ void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg)
                 GKI_freebuf (GKI_dequeue (&p_srvc_cb->cache_buffer));
 
             p_srvc_cb->p_srvc_cache = NULL;
+            p_srvc_cb->notif_handle = 0;
         }
     }
     /* used to reset cache in application */
@@ -2024,6 +2026,40 @@ void bta_gattc_proc_other_indication(tBTA_GATTC_CLCB *p_clcb, UINT8 op,
         (*p_clcb->p_rcb->p_cback)(BTA_GATTC_NOTIF_EVT,  (tBTA_GATTC *)p_notify);
 
 }
+/*******************************************************************************
+**
+** Function         bta_gattc_notif_handle2id
+**
+** Description      resolve a notified handle into its ids, reusing the last
+**                  resolution of the server when the handle repeats.
+**
+** Returns          TRUE if the handle is in the cache.
+**
+*******************************************************************************/
+static BOOLEAN bta_gattc_notif_handle2id(tBTA_GATTC_SERV *p_srcb, UINT16 handle,
+                                         tBTA_GATTC_NOTIFY *p_notify)
+{
+    if (handle != 0 && handle == p_srcb->notif_handle)
+    {
+        memcpy(&p_notify->char_id.srvc_id, &p_srcb->notif_srvc_id, sizeof(tBTA_GATT_SRVC_ID));
+        memcpy(&p_notify->char_id.char_id, &p_srcb->notif_char_id, sizeof(tBTA_GATT_ID));
+        memcpy(&p_notify->descr_type, &p_srcb->notif_descr_type, sizeof(tBTA_GATT_ID));
+        return TRUE;
+    }
+
+    if (!bta_gattc_handle2id(p_srcb, handle,
+                             &p_notify->char_id.srvc_id,
+                             &p_notify->char_id.char_id,
+                             &p_notify->descr_type))
+        return FALSE;
+
+    p_srcb->notif_handle = handle;
+    memcpy(&p_srcb->notif_srvc_id, &p_notify->char_id.srvc_id, sizeof(tBTA_GATT_SRVC_ID));
+    memcpy(&p_srcb->notif_char_id, &p_notify->char_id.char_id, sizeof(tBTA_GATT_ID));
+    memcpy(&p_srcb->notif_descr_type, &p_notify->descr_type, sizeof(tBTA_GATT_ID));
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         bta_gattc_process_indicate
@@ -2064,10 +2100,7 @@ void bta_gattc_process_indicate(UINT16 conn_id, tGATTC_OPTYPE op, tGATT_CL_COMPL
 
     p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
-    if (bta_gattc_handle2id(p_srcb, handle,
-                            &notify.char_id.srvc_id,
-                            &notify.char_id.char_id,
-                            &notify.descr_type))
+    if (bta_gattc_notif_handle2id(p_srcb, handle, &notify))
     {
         /* if non-service change indication/notification, forward to application */
         if (!bta_gattc_process_srvc_chg_ind(conn_id, p_clrcb, p_srcb, p_clcb, &notify, handle))
@@ -173,6 +173,7 @@ tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
 
     while (p_srvc_cb->cache_buffer.p_first)
         GKI_freebuf (GKI_dequeue (&p_srvc_cb->cache_buffer));
+    p_srvc_cb->notif_handle = 0;
 
     utl_freebuf((void **)&p_srvc_cb->p_srvc_list);
 
@@ -1515,6 +1516,7 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
     {
         while (p_srvc_cb->cache_buffer.p_first)
             GKI_freebuf (GKI_dequeue (&p_srvc_cb->cache_buffer));
+        p_srvc_cb->notif_handle = 0;
 
         if (bta_gattc_alloc_cache_buf(p_srvc_cb) == NULL)
         {
@@ -343,6 +343,13 @@ typedef struct
     UINT16              attr_index;     /* cahce NV saving/loading attribute index */
 
     UINT16              mtu;
+
+    /* last notified handle and its ids, so a stream of notifications on one
+       characteristic does not walk the cache; 0 when unset */
+    UINT16              notif_handle;
+    tBTA_GATT_SRVC_ID   notif_srvc_id;
+    tBTA_GATT_ID        notif_char_id;
+    tBTA_GATT_ID        notif_descr_type;
 } tBTA_GATTC_SERV;
 
 #ifndef BTA_GATTC_NOTIF_REG_MAX
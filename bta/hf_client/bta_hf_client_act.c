@@ -39,9 +39,6 @@
 **  Constants
 *****************************************************************************/
 
-/* maximum length of data to read from RFCOMM */
-#define BTA_HF_CLIENT_RFC_READ_MAX     512
-
 /*******************************************************************************
 **
 ** Function         bta_hf_client_register
@@ -504,28 +501,20 @@ void bta_hf_client_disc_acp_res(tBTA_HF_CLIENT_DATA *p_data)
 *******************************************************************************/
 void bta_hf_client_rfc_data(tBTA_HF_CLIENT_DATA *p_data)
 {
-    UINT16  len;
-    char    buf[BTA_HF_CLIENT_RFC_READ_MAX];
+    BT_HDR  *p_buf;
     UNUSED(p_data);
 
-    memset(buf, 0, sizeof(buf));
-
-    /* read data from rfcomm; if bad status, we're done */
-    while (PORT_ReadData(bta_hf_client_cb.scb.conn_handle, buf, BTA_HF_CLIENT_RFC_READ_MAX, &len) == PORT_SUCCESS)
+    /* take the received buffers from rfcomm; if bad status, we're done */
+    while (PORT_Read(bta_hf_client_cb.scb.conn_handle, &p_buf) == PORT_SUCCESS)
     {
         /* if no data, we're done */
-        if (len == 0)
+        if (p_buf == NULL)
         {
             break;
         }
 
-        bta_hf_client_at_parse(buf, len);
-
-        /* no more data to read, we're done */
-        if (len < BTA_HF_CLIENT_RFC_READ_MAX)
-        {
-            break;
-        }
+        bta_hf_client_at_parse((char *)(p_buf + 1) + p_buf->offset, p_buf->len);
+        GKI_freebuf(p_buf);
     }
 }
 
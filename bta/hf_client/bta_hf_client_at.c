@@ -1292,41 +1292,102 @@ static char *bta_hf_client_skip_unknown(char *buffer)
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] =
-{
-    bta_hf_client_parse_ok,
-    bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,
-    bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,
-    bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,
-    bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,
-    bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,
-    bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,
-    bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,
-    bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,
-    bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,
-    bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,
-    bta_hf_client_parse_btrh,
-    bta_hf_client_parse_busy,
-    bta_hf_client_parse_delayed,
-    bta_hf_client_parse_no_carrier,
-    bta_hf_client_parse_no_answer,
-    bta_hf_client_parse_blacklisted,
-    bta_hf_client_skip_unknown
+typedef struct
+{
+    const char                      *p_evt;     /* event as checked by the parser */
+    tBTA_HF_CLIENT_PARSER_CALLBACK  p_parse;
+} tBTA_HF_CLIENT_PARSER;
+
+/* supported events, sorted by name (strcmp order) for binary search */
+static const tBTA_HF_CLIENT_PARSER bta_hf_client_parser[] =
+{
+    {"+BCS:",           bta_hf_client_parse_bcs},
+    {"+BINP:",          bta_hf_client_parse_binp},
+    {"+BRSF:",          bta_hf_client_parse_brsf},
+    {"+BSIR:",          bta_hf_client_parse_bsir},
+    {"+BTRH:",          bta_hf_client_parse_btrh},
+    {"+BVRA:",          bta_hf_client_parse_bvra},
+    {"+CCWA:",          bta_hf_client_parse_ccwa},
+    {"+CHLD:",          bta_hf_client_parse_chld},
+    {"+CIEV:",          bta_hf_client_parse_ciev},
+    {"+CIND:",          bta_hf_client_parse_cind},
+    {"+CLCC:",          bta_hf_client_parse_clcc},
+    {"+CLIP:",          bta_hf_client_parse_clip},
+    {"+CME ERROR:",     bta_hf_client_parse_cmeerror},
+    {"+CNUM:",          bta_hf_client_parse_cnum},
+    {"+COPS:",          bta_hf_client_parse_cops},
+    {"+VGM:",           bta_hf_client_parse_vgm},
+    {"+VGM=",           bta_hf_client_parse_vgme},
+    {"+VGS:",           bta_hf_client_parse_vgs},
+    {"+VGS=",           bta_hf_client_parse_vgse},
+    {"BLACKLISTED",     bta_hf_client_parse_blacklisted},
+    {"BUSY",            bta_hf_client_parse_busy},
+    {"DELAYED",         bta_hf_client_parse_delayed},
+    {"ERROR",           bta_hf_client_parse_error},
+    {"NO ANSWER",       bta_hf_client_parse_no_answer},
+    {"NO CARRIER",      bta_hf_client_parse_no_carrier},
+    {"OK",              bta_hf_client_parse_ok},
+    {"RING",            bta_hf_client_parse_ring}
 };
 
 /* calculate supported event list length */
-static const UINT16 bta_hf_client_psraser_cb_count =
-        sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+static const UINT16 bta_hf_client_parser_count =
+        sizeof(bta_hf_client_parser) / sizeof(bta_hf_client_parser[0]);
+
+/* find the parser of the event at buf, NULL if the event is not supported */
+static tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_find_parser(const char *buf)
+{
+    const char *p_evt;
+    const char *p;
+    size_t len;
+    int lo = 0;
+    int hi = bta_hf_client_parser_count - 1;
+    int mid, res;
+
+    if (buf[0] != '\r' || buf[1] != '\n')
+    {
+        return NULL;
+    }
+    p_evt = buf + 2;
+
+    /* the event name ends after ':' or '=', or before <cr> and any spaces */
+    for (p = p_evt; *p != ':' && *p != '=' && *p != '\r' && *p != '\0'; p++)
+        ;
+    if (*p == ':' || *p == '=')
+    {
+        p++;
+    }
+    else
+    {
+        while (p > p_evt && p[-1] == ' ')
+            p--;
+    }
+    len = p - p_evt;
+
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        res = strncmp(bta_hf_client_parser[mid].p_evt, p_evt, len);
+        if (res == 0 && bta_hf_client_parser[mid].p_evt[len] != '\0')
+        {
+            res = 1;
+        }
+
+        if (res == 0)
+        {
+            return bta_hf_client_parser[mid].p_parse;
+        }
+        else if (res < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(void)
@@ -1375,26 +1436,24 @@ static void bta_hf_client_at_parse_start(void)
 
     while(*buf != '\0')
     {
-        int i;
+        tBTA_HF_CLIENT_PARSER_CALLBACK p_parse;
         char *tmp = NULL;
 
-        for(i = 0; i < bta_hf_client_psraser_cb_count; i++)
+        p_parse = bta_hf_client_find_parser(buf);
+        if (p_parse != NULL)
         {
-            tmp = bta_hf_client_parser_cb[i](buf);
+            tmp = p_parse(buf);
             if (tmp == NULL)
             {
                 APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
-                tmp = bta_hf_client_skip_unknown(buf);
-                break;
             }
+        }
 
-            /* matched or unknown skipped, if unknown failed tmp is NULL so
-               this is also handled */
-            if (tmp != buf)
-            {
-                buf = tmp;
-                break;
-            }
+        /* unknown or failed, skip to the next event; if that fails tmp is
+           NULL so this is also handled */
+        if (tmp == NULL || tmp == buf)
+        {
+            tmp = bta_hf_client_skip_unknown(buf);
         }
 
         /* could not skip unknown (received garbage?)... disconnect */
@@ -1430,7 +1489,8 @@ static BOOLEAN bta_hf_client_check_at_complete(void)
 
 static void bta_hf_client_at_clear_buf(void)
 {
-    memset(bta_hf_client_cb.scb.at_cb.buf, 0, sizeof(bta_hf_client_cb.scb.at_cb.buf));
+    /* only the string is parsed, appended data is terminated again */
+    bta_hf_client_cb.scb.at_cb.buf[0] = '\0';
     bta_hf_client_cb.scb.at_cb.offset = 0;
 }
 
@@ -1488,6 +1548,7 @@ void bta_hf_client_at_parse(char *buf, unsigned int len)
 
     memcpy(bta_hf_client_cb.scb.at_cb.buf + bta_hf_client_cb.scb.at_cb.offset, buf, len);
     bta_hf_client_cb.scb.at_cb.offset += len;
+    bta_hf_client_cb.scb.at_cb.buf[bta_hf_client_cb.scb.at_cb.offset] = '\0';
 
     /* If last event is complete, parsing can be started */
     if (bta_hf_client_check_at_complete() == TRUE)
@@ -275,6 +275,7 @@ typedef struct
     UINT8               total_srvc;
     UINT8               clt_cfg_idx;
     UINT8               cur_srvc_index; /* currently discovering service index */
+    tBTA_HH_LE_RPT      *p_notif_rpt;   /* report of the last input notification */
     BOOLEAN             scps_supported;
 
 #define BTA_HH_LE_SCPS_NOTIFY_NONE    0
@@ -1375,6 +1375,7 @@ void bta_hh_clear_service_cache(tBTA_HH_DEV_CB *p_cb)
     p_cb->app_id = 0;
     p_cb->total_srvc = 0;
     p_cb->dscp_info.descriptor.dsc_list = NULL;
+    p_cb->p_notif_rpt = NULL;
 
     for (i = 0; i < BTA_HH_LE_HID_SRVC_MAX; i ++, p_hid_srvc ++)
     {
@@ -2356,6 +2357,7 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
     UINT8           app_id;
     UINT8           *p_buf;
     tBTA_HH_LE_RPT  *p_rpt;
+    UINT8           rpt_buf[BTA_GATT_MAX_ATTR_LEN + 1];
 
     if (p_dev_cb == NULL)
     {
@@ -2364,10 +2366,19 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
     }
     app_id= p_dev_cb->app_id;
 
-    p_rpt = bta_hh_le_find_report_entry(p_dev_cb,
-                                        BTA_HH_LE_SRVC_DEF,
-                                        p_data->char_id.char_id.uuid.uu.uuid16,
-                                        p_data->char_id.char_id.inst_id);
+    /* input reports keep coming on the same characteristic, try it first */
+    p_rpt = p_dev_cb->p_notif_rpt;
+    if (p_rpt == NULL ||
+        p_rpt->uuid != p_data->char_id.char_id.uuid.uu.uuid16 ||
+        p_rpt->inst_id != BTA_HH_LE_RPT_INST_ID_MAP(BTA_HH_LE_SRVC_DEF,
+                                                    p_data->char_id.char_id.inst_id))
+    {
+        p_rpt = bta_hh_le_find_report_entry(p_dev_cb,
+                                            BTA_HH_LE_SRVC_DEF,
+                                            p_data->char_id.char_id.uuid.uu.uuid16,
+                                            p_data->char_id.char_id.inst_id);
+        p_dev_cb->p_notif_rpt = p_rpt;
+    }
     if (p_rpt == NULL)
     {
         APPL_TRACE_ERROR("notification received for Unknown Report");
@@ -2384,12 +2395,13 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
     /* need to append report ID to the head of data */
     if (p_rpt->rpt_id != 0)
     {
-        if ((p_buf = (UINT8 *)GKI_getbuf((UINT16)(p_data->len + 1))) == NULL)
+        if (p_data->len >= sizeof(rpt_buf))
         {
-            APPL_TRACE_ERROR("No resources to send report data");
+            APPL_TRACE_ERROR("Report data too long: %d", p_data->len);
             return;
         }
 
+        p_buf = rpt_buf;
         p_buf[0] = p_rpt->rpt_id;
         memcpy(&p_buf[1], p_data->value, p_data->len);
         ++p_data->len;
@@ -2405,9 +2417,6 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
                     p_dev_cb->dscp_info.ctry_code,
                     p_dev_cb->addr,
                     app_id);
-
-    if (p_buf != p_data->value)
-        GKI_freebuf(p_buf);
 }
 
 /*******************************************************************************
@@ -23,6 +23,9 @@
 #include "bta_dm_co.h"
 #include "bta_dm_ci.h"
 #include "bt_utils.h"
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+#include "btif_sco_hci.h"
+#endif
 #if (BTM_OOB_INCLUDED == TRUE)
 #include "btif_dm.h"
 #endif
@@ -188,24 +191,8 @@ void bta_dm_co_rmt_oob(BD_ADDR bd_addr)
 #endif /* BTM_OOB_INCLUDED */
 
 
-// REMOVE FOR BLUEDROID ?
-
 #if (BTM_SCO_HCI_INCLUDED == TRUE ) && (BTM_SCO_INCLUDED == TRUE)
 
-/*******************************************************************************
-**
-** Function         btui_sco_codec_callback
-**
-** Description      Callback for btui codec.
-**
-**
-** Returns          void
-**
-*******************************************************************************/
-static void btui_sco_codec_callback(UINT16 event, UINT16 sco_handle)
-{
-    bta_dm_sco_ci_data_ready(event, sco_handle);
-}
 /*******************************************************************************
 **
 ** Function         bta_dm_sco_co_init
@@ -221,36 +208,18 @@ static void btui_sco_codec_callback(UINT16 event, UINT16 sco_handle)
 tBTA_DM_SCO_ROUTE_TYPE bta_dm_sco_co_init(UINT32 rx_bw, UINT32 tx_bw,
                                           tBTA_CODEC_INFO * p_codec_type, UINT8 app_id)
 {
-    tBTM_SCO_ROUTE_TYPE route = BTA_DM_SCO_ROUTE_PCM;
+    UNUSED(tx_bw);
+    UNUSED(p_codec_type);
+    UNUSED(app_id);
 
-    BTIF_TRACE_DEBUG("bta_dm_sco_co_init");
-
-    /* set up SCO routing configuration if SCO over HCI app ID is used and run time
-        configuration is set to SCO over HCI */
-    /* HS invoke this call-out */
-    if (
-#if (BTA_HS_INCLUDED == TRUE ) && (BTA_HS_INCLUDED == TRUE)
-       (app_id == BTUI_DM_SCO_4_HS_APP_ID && btui_cfg.hs_sco_over_hci) ||
-#endif
-       /* AG invoke this call-out */
-       (app_id != BTUI_DM_SCO_4_HS_APP_ID && btui_cfg.ag_sco_over_hci ))
-    {
-        route = btui_cb.sco_hci = BTA_DM_SCO_ROUTE_HCI;
-    }
-    /* no codec is is used for the SCO data */
-    if (p_codec_type->codec_type == BTA_SCO_CODEC_PCM && route == BTA_DM_SCO_ROUTE_HCI)
-    {
-        /* initialize SCO codec */
-        if (!btui_sco_codec_init(rx_bw, tx_bw))
-        {
-            BTIF_TRACE_ERROR("codec initialization exception!");
-        }
-    }
-
-    return route;
-}
+    BTIF_TRACE_DEBUG("bta_dm_sco_co_init rx_bw:%d", rx_bw);
 
+    /* fall back to the PCM interface if the audio HAL side cannot be set up */
+    if (!btif_sco_hci_init(rx_bw))
+        return BTA_DM_SCO_ROUTE_PCM;
 
+    return BTA_DM_SCO_ROUTE_HCI;
+}
 
 /*******************************************************************************
 **
@@ -264,20 +233,8 @@ tBTA_DM_SCO_ROUTE_TYPE bta_dm_sco_co_init(UINT32 rx_bw, UINT32 tx_bw,
 *******************************************************************************/
 void bta_dm_sco_co_open(UINT16 handle, UINT8 pkt_size, UINT16 event)
 {
-    tBTUI_SCO_CODEC_CFG cfg;
-
-    if (btui_cb.sco_hci)
-    {
-        BTIF_TRACE_DEBUG("bta_dm_sco_co_open handle:%d pkt_size:%d", handle, pkt_size);
-        /* use dedicated SCO buffer pool for SCO TX data */
-        cfg.pool_id = HCI_SCO_POOL_ID;
-        cfg.p_cback = btui_sco_codec_callback;
-        cfg.pkt_size = pkt_size;
-        cfg.cb_event = event;
-        /* open and start the codec */
-        btui_sco_codec_open(&cfg);
-        btui_sco_codec_start(handle);
-    }
+    BTIF_TRACE_DEBUG("bta_dm_sco_co_open handle:%d pkt_size:%d", handle, pkt_size);
+    btif_sco_hci_open(handle, pkt_size, event);
 }
 
 /*******************************************************************************
@@ -292,14 +249,8 @@ void bta_dm_sco_co_open(UINT16 handle, UINT8 pkt_size, UINT16 event)
 *******************************************************************************/
 void bta_dm_sco_co_close(void)
 {
-    if (btui_cb.sco_hci)
-    {
-        BTIF_TRACE_DEBUG("bta_dm_sco_co_close close codec");
-        /* close sco codec */
-        btui_sco_codec_close();
-
-        btui_cb.sco_hci = FALSE;
-    }
+    BTIF_TRACE_DEBUG("bta_dm_sco_co_close");
+    btif_sco_hci_close();
 }
 
 /*******************************************************************************
@@ -311,12 +262,9 @@ void bta_dm_sco_co_close(void)
 ** Returns          void
 **
 *******************************************************************************/
-void bta_dm_sco_co_in_data(BT_HDR  *p_buf)
+void bta_dm_sco_co_in_data(BT_HDR  *p_buf, tBTM_SCO_DATA_FLAG status)
 {
-    if (btui_cfg.sco_use_mic)
-        btui_sco_codec_inqdata (p_buf);
-    else
-        GKI_freebuf(p_buf);
+    btif_sco_hci_in_data(p_buf, status);
 }
 
 /*******************************************************************************
@@ -330,7 +278,7 @@ void bta_dm_sco_co_in_data(BT_HDR  *p_buf)
 *******************************************************************************/
 void bta_dm_sco_co_out_data(BT_HDR  **p_buf)
 {
-    btui_sco_codec_readbuf(p_buf);
+    btif_sco_hci_out_data(p_buf);
 }
 
 #endif /* #if (BTM_SCO_HCI_INCLUDED == TRUE ) && (BTM_SCO_INCLUDED == TRUE)*/
@@ -20,11 +20,14 @@
 
 #include <ctype.h>
 #include <fcntl.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 #include <errno.h>
 #include <linux/uhid.h>
 #include "btif_hh.h"
@@ -42,50 +45,58 @@ static tBTA_HH_RPT_CACHE_ENTRY sReportCache[BTA_HH_NV_LOAD_MAX];
 #endif
 
 /*Internal function to perform UHID write and error checking*/
-static int uhid_write(int fd, const struct uhid_event *ev)
+/* uhid accepts events shorter than struct uhid_event and zero fills the rest,
+ * so only the used part of an event needs to be written */
+static int uhid_write_len(int fd, const struct uhid_event *ev, size_t len)
 {
     ssize_t ret;
-    ret = write(fd, ev, sizeof(*ev));
+    ret = write(fd, ev, len);
     if (ret < 0){
         int rtn = -errno;
         APPL_TRACE_ERROR("%s: Cannot write to uhid:%s", __FUNCTION__, strerror(errno));
         return rtn;
-    } else if (ret != sizeof(*ev)) {
+    } else if ((size_t)ret != len) {
         APPL_TRACE_ERROR("%s: Wrong size written to uhid: %ld != %lu",
-                                                    __FUNCTION__, ret, sizeof(*ev));
+                                                    __FUNCTION__, ret, len);
         return -EFAULT;
     } else {
         return 0;
     }
 }
 
-/* Internal function to parse the events received from UHID driver*/
-static int uhid_event(btif_hh_device_t *p_dev)
+static int uhid_write(int fd, const struct uhid_event *ev)
+{
+    return uhid_write_len(fd, ev, sizeof(*ev));
+}
+
+/* Internal function to parse the events received from UHID driver.
+ * Returns -EAGAIN once the non-blocking uhid fd has been drained. */
+static int uhid_event(btif_hh_device_t *p_dev, struct uhid_event *p_ev)
 {
-    struct uhid_event ev;
     ssize_t ret;
-    memset(&ev, 0, sizeof(ev));
     if(!p_dev)
     {
         APPL_TRACE_ERROR("%s: Device not found",__FUNCTION__)
         return -1;
     }
-    ret = read(p_dev->fd, &ev, sizeof(ev));
+    ret = read(p_dev->fd, p_ev, sizeof(*p_ev));
     if (ret == 0) {
         APPL_TRACE_ERROR("%s: Read HUP on uhid-cdev %s", __FUNCTION__,
                                                  strerror(errno));
         return -EFAULT;
+    } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return -EAGAIN;
     } else if (ret < 0) {
         APPL_TRACE_ERROR("%s:Cannot read uhid-cdev: %s", __FUNCTION__,
                                                 strerror(errno));
         return -errno;
-    } else if (ret != sizeof(ev)) {
+    } else if (ret != sizeof(*p_ev)) {
         APPL_TRACE_ERROR("%s:Invalid size read from uhid-dev: %ld != %lu",
-                            __FUNCTION__, ret, sizeof(ev));
+                            __FUNCTION__, ret, sizeof(*p_ev));
         return -EFAULT;
     }
 
-    switch (ev.type) {
+    switch (p_ev->type) {
     case UHID_START:
         APPL_TRACE_DEBUG("UHID_START from uhid-dev\n");
         break;
@@ -100,14 +111,14 @@ static int uhid_event(btif_hh_device_t *p_dev)
         break;
     case UHID_OUTPUT:
         APPL_TRACE_DEBUG("UHID_OUTPUT: Report type = %d, report_size = %d"
-                            ,ev.u.output.rtype, ev.u.output.size);
+                            ,p_ev->u.output.rtype, p_ev->u.output.size);
         //Send SET_REPORT with feature report if the report type in output event is FEATURE
-        if(ev.u.output.rtype == UHID_FEATURE_REPORT)
-            btif_hh_setreport(p_dev,BTHH_FEATURE_REPORT,ev.u.output.size,ev.u.output.data);
-        else if(ev.u.output.rtype == UHID_OUTPUT_REPORT)
-            btif_hh_setreport(p_dev,BTHH_OUTPUT_REPORT,ev.u.output.size,ev.u.output.data);
+        if(p_ev->u.output.rtype == UHID_FEATURE_REPORT)
+            btif_hh_setreport(p_dev,BTHH_FEATURE_REPORT,p_ev->u.output.size,p_ev->u.output.data);
+        else if(p_ev->u.output.rtype == UHID_OUTPUT_REPORT)
+            btif_hh_setreport(p_dev,BTHH_OUTPUT_REPORT,p_ev->u.output.size,p_ev->u.output.data);
         else
-            btif_hh_setreport(p_dev,BTHH_INPUT_REPORT,ev.u.output.size,ev.u.output.data);
+            btif_hh_setreport(p_dev,BTHH_INPUT_REPORT,p_ev->u.output.size,p_ev->u.output.data);
            break;
     case UHID_OUTPUT_EV:
         APPL_TRACE_DEBUG("UHID_OUTPUT_EV from uhid-dev\n");
@@ -120,88 +131,248 @@ static int uhid_event(btif_hh_device_t *p_dev)
         break;
 
     default:
-        APPL_TRACE_DEBUG("Invalid event from uhid-dev: %u\n", ev.type);
+        APPL_TRACE_DEBUG("Invalid event from uhid-dev: %u\n", p_ev->type);
     }
 
     return 0;
 }
 
+/*******************************************************************************
+**  uhid event loop
+**
+**  All uhid device fds are served by one epoll thread instead of one polling
+**  thread per device. The thread is started with the first device and stopped
+**  with the last one.
+*******************************************************************************/
+
+/* Max events drained from one uhid fd per wake-up before moving to the next */
+#ifndef BTIF_HH_UHID_BATCH
+#define BTIF_HH_UHID_BATCH          8
+#endif
+
+typedef struct
+{
+    pthread_mutex_t     svc_lock;   /* serializes add/remove, start/stop */
+    pthread_mutex_t     lock;       /* serializes dispatch against removal */
+    pthread_t           thread_id;
+    BOOLEAN             running;
+    int                 epoll_fd;
+    int                 cmd_fdr;
+    int                 cmd_fdw;
+    int                 dev_count;
+    UINT32              wakeups;
+    UINT32              events;
+    struct uhid_event   ev;         /* read buffer shared by all devices */
+} btif_hh_uhid_cb_t;
+
+static btif_hh_uhid_cb_t btif_hh_uhid_cb =
+{
+    .svc_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .epoll_fd = -1,
+    .cmd_fdr = -1,
+    .cmd_fdw = -1,
+};
+
 /*******************************************************************************
 **
-** Function create_thread
+** Function btif_hh_uhid_service
 **
-** Description creat a select loop
+** Description drain up to BTIF_HH_UHID_BATCH events from one uhid fd.
+**             Called with btif_hh_uhid_cb.lock held.
 **
-** Returns pthread_t
+** Returns void
 **
 *******************************************************************************/
-static inline pthread_t create_thread(void *(*start_routine)(void *), void * arg){
-    APPL_TRACE_DEBUG("create_thread: entered");
-    pthread_attr_t thread_attr;
-
-    pthread_attr_init(&thread_attr);
-    pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-    pthread_t thread_id = -1;
-    if ( pthread_create(&thread_id, &thread_attr, start_routine, arg)!=0 )
-    {
-        APPL_TRACE_ERROR("pthread_create : %s", strerror(errno));
-        return -1;
+static void btif_hh_uhid_service(btif_hh_device_t *p_dev)
+{
+    int n, ret;
+
+    /* removed after epoll_wait returned */
+    if (!p_dev->hh_keep_polling || p_dev->fd < 0)
+        return;
+
+    for (n = 0; n < BTIF_HH_UHID_BATCH; n++) {
+        ret = uhid_event(p_dev, &btif_hh_uhid_cb.ev);
+        if (ret == -EAGAIN)
+            break;
+        if (ret) {
+            /* stop watching; the device stays registered until it is closed */
+            epoll_ctl(btif_hh_uhid_cb.epoll_fd, EPOLL_CTL_DEL, p_dev->fd, NULL);
+            break;
+        }
+        btif_hh_uhid_cb.events++;
     }
-    APPL_TRACE_DEBUG("create_thread: thread created successfully");
-    return thread_id;
 }
 
 /*******************************************************************************
 **
-** Function btif_hh_poll_event_thread
+** Function btif_hh_uhid_thread
 **
-** Description the polling thread which polls for event from UHID driver
+** Description the event loop which serves all uhid devices
 **
 ** Returns void
 **
 *******************************************************************************/
-static void *btif_hh_poll_event_thread(void *arg)
+static void *btif_hh_uhid_thread(void *arg)
 {
-
-    btif_hh_device_t *p_dev = arg;
-    APPL_TRACE_DEBUG("%s: Thread created fd = %d", __FUNCTION__, p_dev->fd);
-    struct pollfd pfds[1];
-    int ret;
-    pfds[0].fd = p_dev->fd;
-    pfds[0].events = POLLIN;
-
-    while(p_dev->hh_keep_polling){
-        ret = poll(pfds, 1, 50);
+    struct epoll_event events[BTIF_HH_MAX_HID + 1];
+    BOOLEAN exit_thread = FALSE;
+    int i, ret;
+    UNUSED(arg);
+
+    APPL_TRACE_DEBUG("%s: started", __FUNCTION__);
+    while (!exit_thread) {
+        ret = epoll_wait(btif_hh_uhid_cb.epoll_fd, events, BTIF_HH_MAX_HID + 1, -1);
         if (ret < 0) {
-            APPL_TRACE_ERROR("%s: Cannot poll for fds: %s\n", __FUNCTION__, strerror(errno));
+            if (errno == EINTR)
+                continue;
+            APPL_TRACE_ERROR("%s: Cannot poll for fds: %s", __FUNCTION__, strerror(errno));
             break;
         }
-        if (pfds[0].revents & POLLIN) {
-            APPL_TRACE_DEBUG("btif_hh_poll_event_thread: POLLIN");
-            ret = uhid_event(p_dev);
-            if (ret){
-                break;
-            }
+
+        pthread_mutex_lock(&btif_hh_uhid_cb.lock);
+        btif_hh_uhid_cb.wakeups++;
+        for (i = 0; i < ret; i++) {
+            /* the command pipe is registered with a NULL device */
+            if (events[i].data.ptr == NULL)
+                exit_thread = TRUE;
+            else
+                btif_hh_uhid_service(events[i].data.ptr);
         }
+        pthread_mutex_unlock(&btif_hh_uhid_cb.lock);
     }
 
-    p_dev->hh_poll_thread_id = -1;
+    APPL_TRACE_EVENT("%s: exiting, %u wake-ups, %u uhid events", __FUNCTION__,
+                     btif_hh_uhid_cb.wakeups, btif_hh_uhid_cb.events);
     return 0;
 }
 
-static inline void btif_hh_close_poll_thread(btif_hh_device_t *p_dev)
+static BOOLEAN btif_hh_uhid_start(void)
+{
+    struct epoll_event ev;
+    int fds[2];
+
+    btif_hh_uhid_cb.epoll_fd = epoll_create(BTIF_HH_MAX_HID + 1);
+    if (btif_hh_uhid_cb.epoll_fd < 0 || pipe(fds) < 0) {
+        APPL_TRACE_ERROR("%s: cannot create uhid loop: %s", __FUNCTION__, strerror(errno));
+        if (btif_hh_uhid_cb.epoll_fd >= 0)
+            close(btif_hh_uhid_cb.epoll_fd);
+        btif_hh_uhid_cb.epoll_fd = -1;
+        return FALSE;
+    }
+    btif_hh_uhid_cb.cmd_fdr = fds[0];
+    btif_hh_uhid_cb.cmd_fdw = fds[1];
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(btif_hh_uhid_cb.epoll_fd, EPOLL_CTL_ADD, btif_hh_uhid_cb.cmd_fdr, &ev);
+
+    btif_hh_uhid_cb.wakeups = 0;
+    btif_hh_uhid_cb.events = 0;
+    if (pthread_create(&btif_hh_uhid_cb.thread_id, NULL, btif_hh_uhid_thread, NULL) != 0) {
+        APPL_TRACE_ERROR("pthread_create : %s", strerror(errno));
+        close(btif_hh_uhid_cb.cmd_fdr);
+        close(btif_hh_uhid_cb.cmd_fdw);
+        close(btif_hh_uhid_cb.epoll_fd);
+        btif_hh_uhid_cb.cmd_fdr = btif_hh_uhid_cb.cmd_fdw = btif_hh_uhid_cb.epoll_fd = -1;
+        return FALSE;
+    }
+    btif_hh_uhid_cb.running = TRUE;
+    return TRUE;
+}
+
+static void btif_hh_uhid_stop(void)
 {
-    APPL_TRACE_DEBUG("%s", __FUNCTION__);
-    p_dev->hh_keep_polling = 0;
-    if(p_dev->hh_poll_thread_id > 0)
-        pthread_join(p_dev->hh_poll_thread_id,NULL);
+    char cmd = 0;
 
-    return;
+    btif_hh_uhid_cb.running = FALSE;
+    if (write(btif_hh_uhid_cb.cmd_fdw, &cmd, 1) != 1)
+        APPL_TRACE_ERROR("%s: cannot wake uhid loop: %s", __FUNCTION__, strerror(errno));
+    pthread_join(btif_hh_uhid_cb.thread_id, NULL);
+
+    close(btif_hh_uhid_cb.cmd_fdr);
+    close(btif_hh_uhid_cb.cmd_fdw);
+    close(btif_hh_uhid_cb.epoll_fd);
+    btif_hh_uhid_cb.cmd_fdr = btif_hh_uhid_cb.cmd_fdw = btif_hh_uhid_cb.epoll_fd = -1;
+}
+
+/*******************************************************************************
+**
+** Function btif_hh_uhid_add
+**
+** Description register the uhid fd of a device with the event loop
+**
+** Returns void
+**
+*******************************************************************************/
+static void btif_hh_uhid_add(btif_hh_device_t *p_dev)
+{
+    struct epoll_event ev;
+
+    APPL_TRACE_DEBUG("%s: fd = %d", __FUNCTION__, p_dev->fd);
+    pthread_mutex_lock(&btif_hh_uhid_cb.svc_lock);
+    if (btif_hh_uhid_cb.running || btif_hh_uhid_start()) {
+        fcntl(p_dev->fd, F_SETFL, fcntl(p_dev->fd, F_GETFL) | O_NONBLOCK);
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = p_dev;
+
+        pthread_mutex_lock(&btif_hh_uhid_cb.lock);
+        if (epoll_ctl(btif_hh_uhid_cb.epoll_fd, EPOLL_CTL_ADD, p_dev->fd, &ev) == 0) {
+            p_dev->hh_keep_polling = 1;
+            btif_hh_uhid_cb.dev_count++;
+        } else {
+            APPL_TRACE_ERROR("%s: epoll_ctl : %s", __FUNCTION__, strerror(errno));
+        }
+        pthread_mutex_unlock(&btif_hh_uhid_cb.lock);
+
+        if (btif_hh_uhid_cb.dev_count == 0)
+            btif_hh_uhid_stop();
+    }
+    pthread_mutex_unlock(&btif_hh_uhid_cb.svc_lock);
+}
+
+/*******************************************************************************
+**
+** Function btif_hh_uhid_remove
+**
+** Description unregister a device from the event loop. No event of the
+**             device is being dispatched once this returns.
+**
+** Returns void
+**
+*******************************************************************************/
+static void btif_hh_uhid_remove(btif_hh_device_t *p_dev)
+{
+    APPL_TRACE_DEBUG("%s: fd = %d", __FUNCTION__, p_dev->fd);
+    pthread_mutex_lock(&btif_hh_uhid_cb.svc_lock);
+    if (p_dev->hh_keep_polling) {
+        pthread_mutex_lock(&btif_hh_uhid_cb.lock);
+        /* may already be gone if the fd reported an error */
+        epoll_ctl(btif_hh_uhid_cb.epoll_fd, EPOLL_CTL_DEL, p_dev->fd, NULL);
+        p_dev->hh_keep_polling = 0;
+        btif_hh_uhid_cb.dev_count--;
+        pthread_mutex_unlock(&btif_hh_uhid_cb.lock);
+
+        if (btif_hh_uhid_cb.dev_count == 0)
+            btif_hh_uhid_stop();
+    }
+    pthread_mutex_unlock(&btif_hh_uhid_cb.svc_lock);
 }
 
 void bta_hh_co_destroy(int fd)
 {
     struct uhid_event ev;
+    int i;
+
+    for (i = 0; i < BTIF_HH_MAX_HID; i++) {
+        if (btif_hh_cb.devices[i].fd == fd && btif_hh_cb.devices[i].hh_keep_polling)
+            btif_hh_uhid_remove(&btif_hh_cb.devices[i]);
+    }
+
     memset(&ev, 0, sizeof(ev));
     ev.type = UHID_DESTROY;
     uhid_write(fd, &ev);
@@ -211,19 +382,65 @@ void bta_hh_co_destroy(int fd)
 int bta_hh_co_write(int fd, UINT8* rpt, UINT16 len)
 {
     APPL_TRACE_VERBOSE("bta_hh_co_data: UHID write");
+    static BOOLEAN input2_unsupported = FALSE;
     struct uhid_event ev;
-    memset(&ev, 0, sizeof(ev));
-    ev.type = UHID_INPUT;
-    ev.u.input.size = len;
-    if(len > sizeof(ev.u.input.data)){
+    int ret;
+
+    if(len > sizeof(ev.u.input2.data)){
         APPL_TRACE_WARNING("%s:report size greater than allowed size",__FUNCTION__);
         return -1;
     }
+
+    if (!input2_unsupported) {
+        /* the size comes before the data in UHID_INPUT2, so only the header
+           and the report are written, not the whole 4K event */
+        ev.type = UHID_INPUT2;
+        ev.u.input2.size = len;
+        memcpy(ev.u.input2.data, rpt, len);
+        ret = uhid_write_len(fd, &ev, offsetof(struct uhid_event, u.input2.data) + len);
+        if (ret != -EOPNOTSUPP && ret != -EINVAL)
+            return ret;
+
+        /* kernels before 3.16 only know UHID_INPUT */
+        APPL_TRACE_WARNING("%s: UHID_INPUT2 not supported, using UHID_INPUT", __FUNCTION__);
+        input2_unsupported = TRUE;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_INPUT;
+    ev.u.input.size = len;
     memcpy(ev.u.input.data, rpt, len);
     return uhid_write(fd, &ev);
+}
 
+
+/* Count an input report in the device latency histogram */
+static void bta_hh_co_rpt_latency(btif_hh_device_t *p_dev, const struct timespec *p_start,
+                                  const struct timespec *p_end)
+{
+    UINT32 lat_us = (p_end->tv_sec - p_start->tv_sec) * 1000000 +
+                    (p_end->tv_nsec - p_start->tv_nsec) / 1000;
+    int bucket = 0;
+
+    lat_us >>= BTIF_HH_LAT_HIST_SHIFT;
+    while (lat_us != 0 && bucket < BTIF_HH_LAT_HIST_BUCKETS - 1) {
+        lat_us >>= 1;
+        bucket++;
+    }
+    p_dev->rpt_lat_hist[bucket]++;
 }
 
+static void bta_hh_co_rpt_latency_dump(btif_hh_device_t *p_dev)
+{
+    char buf[BTIF_HH_LAT_HIST_BUCKETS * 12];
+    int i, len = 0;
+
+    for (i = 0; i < BTIF_HH_LAT_HIST_BUCKETS; i++)
+        len += snprintf(&buf[len], sizeof(buf) - len, " %u", p_dev->rpt_lat_hist[i]);
+
+    APPL_TRACE_EVENT("%s: dev_handle %d input report latency (<%dus, x2 per bucket):%s",
+                     __FUNCTION__, p_dev->dev_handle, 1 << BTIF_HH_LAT_HIST_SHIFT, buf);
+}
 
 /*******************************************************************************
 **
@@ -266,8 +483,8 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                 }else
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
             }
-            p_dev->hh_keep_polling = 1;
-            p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+            if (p_dev->fd >= 0 && !p_dev->hh_keep_polling)
+                btif_hh_uhid_add(p_dev);
             break;
         }
         p_dev = NULL;
@@ -292,8 +509,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                                                                     __FUNCTION__,strerror(errno));
                 }else{
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
-                    p_dev->hh_keep_polling = 1;
-                    p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+                    btif_hh_uhid_add(p_dev);
                 }
 
 
@@ -308,6 +524,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
     }
 
     p_dev->dev_status = BTHH_CONN_STATE_CONNECTED;
+    memset(p_dev->rpt_lat_hist, 0, sizeof(p_dev->rpt_lat_hist));
     APPL_TRACE_DEBUG("%s: Return device status %d", __FUNCTION__, p_dev->dev_status);
 }
 
@@ -342,7 +559,8 @@ void bta_hh_co_close(UINT8 dev_handle, UINT8 app_id)
                                                         "dev_status = %d, dev_handle =%d"
                                                         ,__FUNCTION__,p_dev->dev_status
                                                         ,p_dev->dev_handle);
-            btif_hh_close_poll_thread(p_dev);
+            btif_hh_uhid_remove(p_dev);
+            bta_hh_co_rpt_latency_dump(p_dev);
             break;
         }
      }
@@ -369,6 +587,7 @@ void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len, tBTA_HH_PROTO_MO
                     UINT8 sub_class, UINT8 ctry_code, BD_ADDR peer_addr, UINT8 app_id)
 {
     btif_hh_device_t *p_dev;
+    struct timespec ts_start, ts_end;
     UNUSED(peer_addr);
 
     APPL_TRACE_VERBOSE("%s: dev_handle = %d, subclass = 0x%02X, mode = %d, "
@@ -382,7 +601,10 @@ void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len, tBTA_HH_PROTO_MO
     }
     // Send the HID report to the kernel.
     if (p_dev->fd >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ts_start);
         bta_hh_co_write(p_dev->fd, p_rpt, len);
+        clock_gettime(CLOCK_MONOTONIC, &ts_end);
+        bta_hh_co_rpt_latency(p_dev, &ts_start, &ts_end);
     }else {
         APPL_TRACE_WARNING("%s: Error: fd = %d, len = %d", __FUNCTION__, p_dev->fd, len);
     }
@@ -20,6 +20,8 @@
 #ifndef BTIF_COMMON_H
 #define BTIF_COMMON_H
 
+#include <stddef.h>
+
 #include "data_types.h"
 #include "bt_types.h"
 #include "bta_api.h"
@@ -168,6 +170,12 @@ typedef struct
     char                 p_param[0]; /* parameter area needs to be last */
 } tBTIF_CONTEXT_SWITCH_CBACK;
 
+/* Records that |copy_len| bytes were copied into the parameter area |p_msg_param|
+** of a message obtained from btif_context_msg_alloc. Used for copy statistics only. */
+#define BTIF_CONTEXT_MSG_COPIED(p_msg_param, copy_len) \
+    (((tBTIF_CONTEXT_SWITCH_CBACK *)((char *)(p_msg_param) - \
+        offsetof(tBTIF_CONTEXT_SWITCH_CBACK, p_param)))->hdr.len += (UINT16)(copy_len))
+
 
 /*******************************************************************************
 **  Functions
@@ -175,6 +183,8 @@ typedef struct
 
 bt_status_t btif_transfer_context (tBTIF_CBACK *p_cback, UINT16 event, char* p_params,
                                     int param_len, tBTIF_COPY_CBACK *p_copy_cback);
+char *btif_context_msg_alloc(tBTIF_CBACK *p_cback, UINT16 event, int param_len);
+void btif_context_msg_send(char *p_param);
 tBTA_SERVICE_MASK btif_get_enabled_services_mask(void);
 bt_status_t btif_enable_service(tBTA_SERVICE_ID service_id);
 bt_status_t btif_disable_service(tBTA_SERVICE_ID service_id);
@@ -28,7 +28,40 @@
 #ifndef BTIF_GATT_H
 #define BTIF_GATT_H
 
+#include "data_types.h"
 
+/* LE scan report counters since GATT was initialized */
+typedef struct
+{
+    UINT32  received;       /* reports received from the stack */
+    UINT32  suppressed;     /* repeated reports dropped by the report filter */
+    UINT32  delivered;      /* reports passed to scan_result_cb */
+    UINT32  batches;        /* btif task wake-ups which delivered them */
+} btif_gattc_scan_stats_t;
+
+/*******************************************************************************
+**
+** Function         btif_gattc_get_scan_stats
+**
+** Description      Get the LE scan report counters
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_gattc_get_scan_stats(btif_gattc_scan_stats_t *p_stats);
+
+/*******************************************************************************
+**
+** Function         btif_gattc_scan_reset
+**
+** Description      Drop the queued LE scan reports, the report filter and the
+**                  counters. free_reports is FALSE if GKI was restarted since
+**                  the reports were queued.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_gattc_scan_reset(BOOLEAN free_reports);
 
 #endif
 
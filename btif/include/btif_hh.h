@@ -43,6 +43,11 @@
 #define BTIF_HH_KEYSTATE_MASK_CAPSLOCK   0x02
 #define BTIF_HH_KEYSTATE_MASK_SCROLLLOCK 0x04
 
+/* Input report latency histogram: bucket 0 is below 1 << SHIFT us and each
+ * following bucket doubles, the last one collects everything slower */
+#define BTIF_HH_LAT_HIST_SHIFT           4
+#define BTIF_HH_LAT_HIST_BUCKETS         10
+
 
 /*******************************************************************************
 **  Type definitions and return values
@@ -68,11 +73,11 @@ typedef struct
     UINT8                         sub_class;
     UINT8                         app_id;
     int                           fd;
-    UINT32                        hh_poll_thread_id;
-    UINT8                         hh_keep_polling;
+    UINT8                         hh_keep_polling; // uhid fd is served by the uhid event loop
     BOOLEAN                       vup_timer_active;
     TIMER_LIST_ENT                vup_timer;
     BOOLEAN                       local_vup; // Indicated locally initiated VUP
+    UINT32                        rpt_lat_hist[BTIF_HH_LAT_HIST_BUCKETS]; // input report to uhid write
 } btif_hh_device_t;
 
 /* Control block to maintain properties of devices */
@@ -32,6 +32,7 @@
 #include "gki.h"
 #include "btif_av_api.h"
 #include "audio_a2dp_hw.h"
+#include "sbc_encoder.h"
 
 /*******************************************************************************
  **  Constants
@@ -260,6 +261,30 @@ extern BOOLEAN btif_media_task_audio_feeding_init_req(tBTIF_MEDIA_INIT_AUDIO_FEE
  *******************************************************************************/
 extern void dump_codec_info(unsigned char *p_codec);
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_sbc_enc_acquire
+ **
+ ** Description      Take the SBC encoder for p_enc, shared between A2DP and
+ **                  mSBC for SCO over HCI. Resets the encoder state if
+ **                  another instance used it last.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_sbc_enc_acquire(SBC_ENC_PARAMS *p_enc);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_sbc_enc_release
+ **
+ ** Description      Give back the SBC encoder
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_sbc_enc_release(void);
+
 /**
  * Local adaptation helper functions between btif and media task
  */
@@ -81,8 +81,8 @@ typedef struct
     int open_count;
     int flow; // 1: outbound data flow on; 0: outbound data flow off
     btpan_conn_t conns[MAX_PAN_CONNS];
-    int congest_packet_size;
-    unsigned char congest_packet[1600]; //max ethernet packet size
+    BT_HDR *congest_buf; //tap frame BNEP had no room for, retried before reading again
+    tETH_HDR congest_hdr;
 } btpan_cb_t;
 
 
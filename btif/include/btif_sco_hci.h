@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_sco_hci.h
+ *
+ *  Description:   SCO/eSCO audio routed over HCI. Voice is exchanged with the
+ *                 audio HAL as 16 bit mono PCM through two single producer,
+ *                 single consumer rings in a shared memory file.
+ *
+ *******************************************************************************/
+
+#ifndef BTIF_SCO_HCI_H
+#define BTIF_SCO_HCI_H
+
+#include "bt_target.h"
+#include "data_types.h"
+
+/*******************************************************************************
+ **  Shared memory layout, also used by the audio HAL
+ *******************************************************************************/
+
+#define BTIF_SCO_SHM_PATH       "/data/misc/bluedroid/.sco_shm"
+#define BTIF_SCO_SHM_MAGIC      0x53434f31      /* "SCO1" */
+
+/* Bytes per ring, a power of 2. 128 ms of wideband speech. */
+#define BTIF_SCO_RING_SIZE      4096
+
+/* head is only written by the producer, tail only by the consumer. Both run
+ * freely and are reduced modulo BTIF_SCO_RING_SIZE on access. */
+typedef struct
+{
+    volatile UINT32 head;
+    volatile UINT32 tail;
+    UINT8           data[BTIF_SCO_RING_SIZE];
+} tBTIF_SCO_RING;
+
+typedef struct
+{
+    UINT32          magic;
+    volatile UINT32 sample_rate;    /* 8000 or 16000, 0 while no SCO is open */
+    tBTIF_SCO_RING  rx;             /* speaker: stack -> HAL */
+    tBTIF_SCO_RING  tx;             /* microphone: HAL -> stack */
+} tBTIF_SCO_SHM;
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+
+#include "gki.h"
+#include "btm_api.h"
+
+/*******************************************************************************
+ **  Functions, called in BTU task context from the DM SCO callouts
+ *******************************************************************************/
+
+/*******************************************************************************
+**
+** Function         btif_sco_hci_init
+**
+** Description      Prepare the shared memory and the codec for a SCO
+**                  connection. mSBC is used for 16 kHz, PCM is passed through
+**                  to the controller's CVSD codec for 8 kHz.
+**
+** Returns          TRUE if SCO can be routed over HCI
+**
+*******************************************************************************/
+extern BOOLEAN btif_sco_hci_init(UINT32 sample_rate);
+
+/*******************************************************************************
+**
+** Function         btif_sco_hci_open
+**
+** Description      Start streaming. event is sent back to BTA with
+**                  bta_dm_sco_ci_data_ready() whenever a packet may be sent.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_sco_hci_open(UINT16 handle, UINT8 pkt_size, UINT16 event);
+
+/*******************************************************************************
+**
+** Function         btif_sco_hci_close
+**
+** Description      Stop streaming
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_sco_hci_close(void);
+
+/*******************************************************************************
+**
+** Function         btif_sco_hci_in_data
+**
+** Description      Process a received SCO packet, frees p_buf
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_sco_hci_in_data(BT_HDR *p_buf, tBTM_SCO_DATA_FLAG status);
+
+/*******************************************************************************
+**
+** Function         btif_sco_hci_out_data
+**
+** Description      Get the next SCO packet to send, NULL if none is due
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void btif_sco_hci_out_data(BT_HDR **pp_buf);
+
+#endif /* BTM_SCO_HCI_INCLUDED == TRUE */
+
+#endif /* BTIF_SCO_HCI_H */
@@ -40,6 +40,7 @@ typedef void (*btsock_cmd_cb)(int cmd_fd, int type, int size, uint32_t user_id);
 
 int btsock_thread_init();
 int btsock_thread_add_fd(int handle, int fd, int type, int flags, uint32_t user_id);
+int btsock_thread_remove_fd(int handle, int fd);
 int btsock_thread_wakeup(int handle);
 int btsock_thread_post_cmd(int handle, int cmd_type, const unsigned char* cmd_data,
                            int data_size, uint32_t user_id);
@@ -127,6 +127,14 @@ static int btif_pending_mode = BT_SCAN_MODE_NONE;
 */
 static UINT8 btif_dut_mode = 0;
 
+/* Context switch statistics, only updated from the btif task */
+static struct
+{
+    UINT32 num_msgs;
+    UINT32 bytes_copied;
+    UINT32 period_start;
+} btif_ctx_stats;
+
 /************************************************************************************
 **  Static functions
 ************************************************************************************/
@@ -181,16 +189,84 @@ void bte_main_config_hci_logging(BOOLEAN enable, BOOLEAN bt_disabled);
 static void btif_context_switched(void *p_msg)
 {
     tBTIF_CONTEXT_SWITCH_CBACK *p;
+    UINT32 now;
 
     BTIF_TRACE_VERBOSE("btif_context_switched");
 
     p = (tBTIF_CONTEXT_SWITCH_CBACK *) p_msg;
 
+    /* hdr.len carries the number of parameter bytes copied by the producer */
+    btif_ctx_stats.num_msgs++;
+    btif_ctx_stats.bytes_copied += p->hdr.len;
+
+    now = GKI_get_os_tick_count();
+    if ((now - btif_ctx_stats.period_start) >= GKI_SECS_TO_TICKS(1))
+    {
+        BTIF_TRACE_DEBUG("%s: %u msgs/s, %u bytes copied/s", __FUNCTION__,
+                         btif_ctx_stats.num_msgs, btif_ctx_stats.bytes_copied);
+        btif_ctx_stats.num_msgs = 0;
+        btif_ctx_stats.bytes_copied = 0;
+        btif_ctx_stats.period_start = now;
+    }
+
     /* each callback knows how to parse the data */
     if (p->p_cb)
         p->p_cb(p->event, p->p_param);
 }
 
+/*******************************************************************************
+**
+** Function         btif_context_msg_alloc
+**
+** Description      Allocates a context switch message for the btif task and
+**                  returns its parameter area. The caller builds the event
+**                  parameters in place and hands the message over with
+**                  btif_context_msg_send, which avoids copying them.
+**
+**                  p_cback   : callback used to process message in btif context
+**                  event     : event id of message
+**                  param_len : length of parameter area
+**
+** Returns          Pointer to the parameter area, NULL if out of buffers
+**
+*******************************************************************************/
+
+char *btif_context_msg_alloc(tBTIF_CBACK *p_cback, UINT16 event, int param_len)
+{
+    tBTIF_CONTEXT_SWITCH_CBACK *p_msg;
+
+    if ((p_msg = (tBTIF_CONTEXT_SWITCH_CBACK *) GKI_getbuf(sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len)) == NULL)
+        return NULL;
+
+    p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT; /* internal event */
+    p_msg->hdr.len = 0;
+    p_msg->p_cb = p_cback;
+    p_msg->event = event;                         /* callback event */
+
+    return p_msg->p_param;
+}
+
+/*******************************************************************************
+**
+** Function         btif_context_msg_send
+**
+** Description      Sends a message allocated by btif_context_msg_alloc to the
+**                  btif task. Ownership of the message passes to btif, which
+**                  frees it once the callback has run.
+**
+**                  p_param  : parameter area returned by btif_context_msg_alloc
+**
+** Returns          void
+**
+*******************************************************************************/
+
+void btif_context_msg_send(char *p_param)
+{
+    tBTIF_CONTEXT_SWITCH_CBACK *p_msg = (tBTIF_CONTEXT_SWITCH_CBACK *)
+                    (p_param - offsetof(tBTIF_CONTEXT_SWITCH_CBACK, p_param));
+
+    btif_sendmsg(p_msg);
+}
 
 /*******************************************************************************
 **
@@ -210,29 +286,27 @@ static void btif_context_switched(void *p_msg)
 
 bt_status_t btif_transfer_context (tBTIF_CBACK *p_cback, UINT16 event, char* p_params, int param_len, tBTIF_COPY_CBACK *p_copy_cback)
 {
-    tBTIF_CONTEXT_SWITCH_CBACK *p_msg;
+    char *p_param;
 
     BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event, param_len);
 
     /* allocate and send message that will be executed in btif context */
-    if ((p_msg = (tBTIF_CONTEXT_SWITCH_CBACK *) GKI_getbuf(sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len)) != NULL)
+    if ((p_param = btif_context_msg_alloc(p_cback, event, param_len)) != NULL)
     {
-        p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT; /* internal event */
-        p_msg->p_cb = p_cback;
-
-        p_msg->event = event;                         /* callback event */
-
         /* check if caller has provided a copy callback to do the deep copy */
         if (p_copy_cback)
         {
-            p_copy_cback(event, p_msg->p_param, p_params);
+            p_copy_cback(event, p_param, p_params);
         }
         else if (p_params)
         {
-            memcpy(p_msg->p_param, p_params, param_len);  /* callback parameter data */
+            memcpy(p_param, p_params, param_len);  /* callback parameter data */
         }
 
-        btif_sendmsg(p_msg);
+        if (p_copy_cback || p_params)
+            BTIF_CONTEXT_MSG_COPIED(p_param, param_len);
+
+        btif_context_msg_send(p_param);
         return BT_STATUS_SUCCESS;
     }
     else
@@ -65,6 +65,9 @@ static bt_status_t btif_gatt_init( const btgatt_callbacks_t* callbacks )
 {
     bt_gatt_callbacks = callbacks;
 
+    /* reports queued before a stack restart belong to the old GKI */
+    btif_gattc_scan_reset(FALSE);
+
     return BT_STATUS_SUCCESS;
 }
 
@@ -84,6 +87,8 @@ static void  btif_gatt_cleanup( void )
 
     BTA_GATTC_Disable();
     BTA_GATTS_Disable();
+
+    btif_gattc_scan_reset(TRUE);
 }
 
 static const btgatt_interface_t btgattInterface = {
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #define LOG_TAG "BtGatt.btif"
 
@@ -46,6 +47,8 @@
 #include "btif_storage.h"
 #include "btif_config.h"
 
+#include "btu.h"
+
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
 #include "btif_dm.h"
@@ -111,11 +114,23 @@ typedef enum {
     BTIF_GATTC_DISABLE_BATCH_SCAN
 } btif_gattc_event_t;
 
-#define BTIF_GATT_MAX_OBSERVED_DEV 40
+#define BTIF_GATT_MAX_OBSERVED_DEV 256
+#define BTIF_GATT_OBSERVED_HASH_SIZE 128  /* must be a power of 2 */
+#define BTIF_GATT_OBSERVED_INVALID_IDX 0xFFFF
+
+/* Observed device properties only update the in-memory config while scanning.
+** Saving and pruning the config is batched once per flush period (in seconds).
+*/
+#define BTIF_GATT_OBSERVED_FLUSH_TIMEOUT 5
+
+/* Scan report filter, see BTIF_GATT_SCAN_MIN_INTERVAL */
+#define BTIF_GATT_SCAN_FILTER_SIZE 256
+#define BTIF_GATT_SCAN_FILTER_HASH_SIZE 128  /* must be a power of 2 */
 
 #define BTIF_GATT_OBSERVE_EVT   0x1000
 #define BTIF_GATTC_RSSI_EVT     0x1001
 #define BTIF_GATTC_SCAN_FILTER_EVT   0x1003
+#define BTIF_GATT_OBSERVE_FLUSH_EVT  0x1004
 
 #define ENABLE_BATCH_SCAN 1
 #define DISABLE_BATCH_SCAN 0
@@ -222,14 +237,45 @@ typedef struct
 {
     bt_bdaddr_t bd_addr;
     BOOLEAN     in_use;
-}__attribute__((packed)) btif_gattc_dev_t;
+    BOOLEAN     props_reported;
+    uint8_t     addr_type;
+    uint8_t     dmt_supported;
+    tBT_DEVICE_TYPE device_type;
+    uint16_t    hash_next;
+} btif_gattc_dev_t;
 
 typedef struct
 {
     btif_gattc_dev_t remote_dev[BTIF_GATT_MAX_OBSERVED_DEV];
+    uint16_t           hash_head[BTIF_GATT_OBSERVED_HASH_SIZE];
     uint8_t            addr_type;
-    uint8_t            next_storage_idx;
-}__attribute__((packed)) btif_gattc_dev_cb_t;
+    uint16_t           next_storage_idx;
+    uint16_t           num_dirty;
+    uint32_t           num_reports;
+    uint32_t           num_updates;
+} btif_gattc_dev_cb_t;
+
+/* Last report passed up for an address and payload */
+typedef struct
+{
+    BD_ADDR     bda;
+    BOOLEAN     in_use;
+    int8_t      rssi;
+    uint32_t    payload_hash;
+    uint32_t    time_ms;        /* when the report was passed up */
+    uint16_t    hash_next;      /* index + 1 of the next entry, 0 if none */
+} btif_gattc_scan_ent_t;
+
+typedef struct
+{
+    btif_gattc_scan_ent_t ent[BTIF_GATT_SCAN_FILTER_SIZE];
+    uint16_t    hash_head[BTIF_GATT_SCAN_FILTER_HASH_SIZE]; /* index + 1, 0 if empty */
+    uint16_t    next_idx;
+    BUFFER_Q    report_q;           /* reports waiting for the btif task */
+    BOOLEAN     drain_pending;      /* a BTIF_GATT_OBSERVE_EVT is queued, GKI_disable() protected */
+    volatile BOOLEAN clear_filter;  /* set by btif, the BTU task empties the table */
+    btif_gattc_scan_stats_t stats;
+} btif_gattc_scan_cb_t;
 
 /*******************************************************************************
 **  Static variables
@@ -238,13 +284,20 @@ typedef struct
 extern const btgatt_callbacks_t *bt_gatt_callbacks;
 static btif_gattc_dev_cb_t  btif_gattc_dev_cb;
 static btif_gattc_dev_cb_t  *p_dev_cb = &btif_gattc_dev_cb;
+static TIMER_LIST_ENT btif_gattc_observed_flush_timer;
+static btif_gattc_scan_cb_t btif_gattc_scan_cb;
 static uint8_t rssi_request_client_if;
 
+/* Report filter settings, overridden by bte_load_ble_conf() */
+int btif_gattc_scan_min_interval = BTIF_GATT_SCAN_MIN_INTERVAL;
+int btif_gattc_scan_rssi_delta = BTIF_GATT_SCAN_RSSI_DELTA;
+
 /*******************************************************************************
 **  Static functions
 ********************************************************************************/
 
 static bt_status_t btif_gattc_multi_adv_disable(int client_if);
+static void btif_gattc_upstreams_evt(uint16_t event, char* p_param);
 static void btif_multi_adv_stop_cb(void *p_tle)
 {
     int client_if = ((TIMER_LIST_ENT*)p_tle)->data;
@@ -330,52 +383,287 @@ static void btapp_gattc_free_req_data(UINT16 event, tBTA_GATTC *p_data)
     }
 }
 
+static inline uint16_t btif_gattc_bdaddr_hash(const BD_ADDR p_bda)
+{
+    /* The low address bytes are the most random part of both public and
+    ** random addresses. */
+    return (uint16_t)((p_bda[5] ^ (p_bda[4] << 3) ^ (p_bda[3] << 5))
+                      & (BTIF_GATT_OBSERVED_HASH_SIZE - 1));
+}
+
+static void btif_gattc_flush_observed_dev(void)
+{
+    static const char* exclude_filter[] =
+        {"LinkKey", "LE_KEY_PENC", "LE_KEY_PID", "LE_KEY_PCSRK", "LE_KEY_LENC", "LE_KEY_LCSRK"};
+
+    if (btif_gattc_observed_flush_timer.in_use)
+        btu_stop_timer_oneshot(&btif_gattc_observed_flush_timer);
+
+    if (p_dev_cb->num_dirty == 0)
+        return;
+
+    BTIF_TRACE_DEBUG("%s %d pending updates (reports=%u, config updates=%u)", __FUNCTION__,
+                     p_dev_cb->num_dirty, p_dev_cb->num_reports, p_dev_cb->num_updates);
+    p_dev_cb->num_dirty = 0;
+
+    btif_config_filter_remove("Remote", exclude_filter, sizeof(exclude_filter)/sizeof(char*),
+                              BTIF_STORAGE_MAX_ALLOWED_REMOTE_DEVICE);
+    btif_config_save();
+}
+
+static void btif_gattc_flush_timeout_cb(void *p_tle)
+{
+    UNUSED(p_tle);
+    btif_transfer_context(btif_gattc_upstreams_evt, BTIF_GATT_OBSERVE_FLUSH_EVT,
+                          NULL, 0, NULL);  // Does context switch
+}
+
+/* Updates the in-memory config for an observed device. Saving the config and
+** pruning old entries is deferred to btif_gattc_flush_observed_dev.
+*/
+static void btif_gattc_update_observed_dev(btif_gattc_dev_t *p_dev)
+{
+    bt_property_t properties;
+    bt_device_type_t dev_type = p_dev->device_type;
+    bdstr_t bdstr;
+
+    bd2str(&p_dev->bd_addr, &bdstr);
+    if (p_dev->props_reported)
+        btif_config_set_int("Remote", bdstr, "AddrType", (int)p_dev->addr_type);
+    if (p_dev->dmt_supported)
+        btif_config_set_int("Remote", bdstr, "DMTSupported", TRUE);
+
+    BTIF_STORAGE_FILL_PROPERTY(&properties,
+                BT_PROPERTY_TYPE_OF_DEVICE, sizeof(dev_type), &dev_type);
+    btif_storage_set_remote_device_property(&p_dev->bd_addr, &properties);
+
+    p_dev_cb->num_updates++;
+    p_dev_cb->num_dirty++;
+
+    if (!btif_gattc_observed_flush_timer.in_use)
+    {
+        memset(&btif_gattc_observed_flush_timer, 0, sizeof(TIMER_LIST_ENT));
+        btif_gattc_observed_flush_timer.param = (UINT32)btif_gattc_flush_timeout_cb;
+        btu_start_timer_oneshot(&btif_gattc_observed_flush_timer, BTU_TTYPE_USER_FUNC,
+                                BTIF_GATT_OBSERVED_FLUSH_TIMEOUT);
+    }
+}
+
 static void btif_gattc_init_dev_cb(void)
 {
+    btif_gattc_flush_observed_dev();
     memset(p_dev_cb, 0, sizeof(btif_gattc_dev_cb_t));
+    memset(p_dev_cb->hash_head, 0xFF, sizeof(p_dev_cb->hash_head));
 }
 
-static void btif_gattc_add_remote_bdaddr (BD_ADDR p_bda, uint8_t addr_type)
+static void btif_gattc_unlink_remote_bdaddr(uint16_t idx)
 {
-    BOOLEAN found=FALSE;
-    uint8_t i;
-    for (i = 0; i < BTIF_GATT_MAX_OBSERVED_DEV; i++)
+    btif_gattc_dev_t *p_dev = &p_dev_cb->remote_dev[idx];
+    uint16_t *p_link = &p_dev_cb->hash_head[btif_gattc_bdaddr_hash(p_dev->bd_addr.address)];
+
+    while (*p_link != BTIF_GATT_OBSERVED_INVALID_IDX)
     {
-        if (!p_dev_cb->remote_dev[i].in_use )
+        if (*p_link == idx)
         {
-            memcpy(p_dev_cb->remote_dev[i].bd_addr.address, p_bda, BD_ADDR_LEN);
-            p_dev_cb->addr_type = addr_type;
-            p_dev_cb->remote_dev[i].in_use = TRUE;
-            BTIF_TRACE_DEBUG("%s device added idx=%d", __FUNCTION__, i  );
+            *p_link = p_dev->hash_next;
             break;
         }
+        p_link = &p_dev_cb->remote_dev[*p_link].hash_next;
+    }
+}
+
+static btif_gattc_dev_t *btif_gattc_add_remote_bdaddr (BD_ADDR p_bda, uint8_t addr_type)
+{
+    btif_gattc_dev_t *p_dev;
+    uint16_t hash = btif_gattc_bdaddr_hash(p_bda);
+    uint16_t i = p_dev_cb->next_storage_idx;
+
+    /* Slots are handed out in order, so once the table is full the oldest
+    ** entry is the next one to be overwritten. */
+    p_dev = &p_dev_cb->remote_dev[i];
+    if (p_dev->in_use)
+    {
+        btif_gattc_unlink_remote_bdaddr(i);
+        BTIF_TRACE_DEBUG("%s device overwrite idx=%d", __FUNCTION__, i);
+    }
+    else
+    {
+        BTIF_TRACE_DEBUG("%s device added idx=%d", __FUNCTION__, i);
     }
 
-    if ( i == BTIF_GATT_MAX_OBSERVED_DEV)
+    memset(p_dev, 0, sizeof(btif_gattc_dev_t));
+    memcpy(p_dev->bd_addr.address, p_bda, BD_ADDR_LEN);
+    p_dev->addr_type = addr_type;
+    p_dev->in_use = TRUE;
+    p_dev->hash_next = p_dev_cb->hash_head[hash];
+    p_dev_cb->hash_head[hash] = i;
+    p_dev_cb->addr_type = addr_type;
+
+    if (++p_dev_cb->next_storage_idx >= BTIF_GATT_MAX_OBSERVED_DEV)
+        p_dev_cb->next_storage_idx = 0;
+
+    return p_dev;
+}
+
+static btif_gattc_dev_t *btif_gattc_find_bdaddr (BD_ADDR p_bda)
+{
+    uint16_t i = p_dev_cb->hash_head[btif_gattc_bdaddr_hash(p_bda)];
+
+    while (i != BTIF_GATT_OBSERVED_INVALID_IDX)
     {
-        i= p_dev_cb->next_storage_idx;
-        memcpy(p_dev_cb->remote_dev[i].bd_addr.address, p_bda, BD_ADDR_LEN);
-        p_dev_cb->addr_type = addr_type;
-        p_dev_cb->remote_dev[i].in_use = TRUE;
-        BTIF_TRACE_DEBUG("%s device overwrite idx=%d", __FUNCTION__, i  );
-        p_dev_cb->next_storage_idx++;
-        if (p_dev_cb->next_storage_idx >= BTIF_GATT_MAX_OBSERVED_DEV)
-               p_dev_cb->next_storage_idx = 0;
+        if (!memcmp(p_dev_cb->remote_dev[i].bd_addr.address, p_bda, BD_ADDR_LEN))
+            return &p_dev_cb->remote_dev[i];
+        i = p_dev_cb->remote_dev[i].hash_next;
     }
+    return NULL;
 }
 
-static BOOLEAN btif_gattc_find_bdaddr (BD_ADDR p_bda)
+static uint32_t btif_gattc_scan_hash(const uint8_t *p, int len, uint32_t hash)
 {
-    uint8_t i;
-    for (i = 0; i < BTIF_GATT_MAX_OBSERVED_DEV; i++)
+    /* FNV-1a */
+    while (len--)
     {
-        if (p_dev_cb->remote_dev[i].in_use &&
-            !memcmp(p_dev_cb->remote_dev[i].bd_addr.address, p_bda, BD_ADDR_LEN))
+        hash ^= *p++;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static uint32_t btif_gattc_scan_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static uint16_t btif_gattc_scan_bucket(const BD_ADDR bda, uint32_t payload_hash)
+{
+    return (uint16_t)(btif_gattc_scan_hash(bda, BD_ADDR_LEN, payload_hash)
+                      & (BTIF_GATT_SCAN_FILTER_HASH_SIZE - 1));
+}
+
+/*******************************************************************************
+**
+** Function         btif_gattc_scan_filter
+**
+** Description      Decides in BTU context whether a scan report is passed up.
+**                  A report is dropped if the same address and payload were
+**                  passed up less than btif_gattc_scan_min_interval ms ago,
+**                  unless the RSSI moved by btif_gattc_scan_rssi_delta or more.
+**                  Entries expire with the interval, so they are never flushed.
+**
+** Returns          TRUE if the report is to be passed up
+**
+*******************************************************************************/
+static BOOLEAN btif_gattc_scan_filter(BD_ADDR bda, int8_t rssi, uint8_t *p_data, int data_len)
+{
+    btif_gattc_scan_cb_t *p_cb = &btif_gattc_scan_cb;
+    btif_gattc_scan_ent_t *p_ent;
+    uint32_t payload_hash, now;
+    uint16_t bucket, i, *p_link;
+    int rssi_diff;
+
+    p_cb->stats.received++;
+
+    if (p_cb->clear_filter)
+    {
+        p_cb->clear_filter = FALSE;
+        memset(p_cb->ent, 0, sizeof(p_cb->ent));
+        memset(p_cb->hash_head, 0, sizeof(p_cb->hash_head));
+        p_cb->next_idx = 0;
+    }
+
+    if (btif_gattc_scan_min_interval <= 0)
+        return TRUE;
+
+    payload_hash = btif_gattc_scan_hash(p_data, data_len, 2166136261u);
+    bucket = btif_gattc_scan_bucket(bda, payload_hash);
+    now = btif_gattc_scan_now_ms();
+
+    for (i = p_cb->hash_head[bucket]; i != 0; i = p_ent->hash_next)
+    {
+        p_ent = &p_cb->ent[i - 1];
+        if (p_ent->payload_hash == payload_hash && !memcmp(p_ent->bda, bda, BD_ADDR_LEN))
+            break;
+    }
+
+    if (i != 0)
+    {
+        rssi_diff = rssi - p_ent->rssi;
+        if (rssi_diff < 0)
+            rssi_diff = -rssi_diff;
+
+        if ((now - p_ent->time_ms) < (uint32_t) btif_gattc_scan_min_interval &&
+            (btif_gattc_scan_rssi_delta <= 0 || rssi_diff < btif_gattc_scan_rssi_delta))
+        {
+            p_cb->stats.suppressed++;
+            return FALSE;
+        }
+    }
+    else
+    {
+        /* Slots are reused in order, the oldest entry goes first */
+        p_ent = &p_cb->ent[p_cb->next_idx];
+        if (p_ent->in_use)
         {
-            return TRUE;
+            p_link = &p_cb->hash_head[btif_gattc_scan_bucket(p_ent->bda, p_ent->payload_hash)];
+            while (*p_link != p_cb->next_idx + 1)
+                p_link = &p_cb->ent[*p_link - 1].hash_next;
+            *p_link = p_ent->hash_next;
         }
+
+        memcpy(p_ent->bda, bda, BD_ADDR_LEN);
+        p_ent->payload_hash = payload_hash;
+        p_ent->in_use = TRUE;
+        p_ent->hash_next = p_cb->hash_head[bucket];
+        p_cb->hash_head[bucket] = p_cb->next_idx + 1;
+
+        if (++p_cb->next_idx >= BTIF_GATT_SCAN_FILTER_SIZE)
+            p_cb->next_idx = 0;
     }
-    return FALSE;
+
+    p_ent->rssi = rssi;
+    p_ent->time_ms = now;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btif_gattc_scan_reset
+**
+** Description      Drops the queued scan reports, the report filter and the
+**                  counters. The reports are freed if the GKI instance which
+**                  allocated them is still running.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_gattc_scan_reset(BOOLEAN free_reports)
+{
+    btif_gattc_scan_cb_t *p_cb = &btif_gattc_scan_cb;
+    void *p_buf;
+
+    GKI_disable();
+    if (free_reports)
+    {
+        while ((p_buf = GKI_dequeue(&p_cb->report_q)) != NULL)
+            GKI_freebuf(p_buf);
+    }
+    else
+    {
+        GKI_init_q(&p_cb->report_q);
+    }
+    p_cb->drain_pending = FALSE;
+    memset(&p_cb->stats, 0, sizeof(p_cb->stats));
+    GKI_enable();
+
+    p_cb->clear_filter = TRUE;
+}
+
+void btif_gattc_get_scan_stats(btif_gattc_scan_stats_t *p_stats)
+{
+    *p_stats = btif_gattc_scan_cb.stats;
 }
 
 static void btif_gattc_update_properties ( btif_gattc_cb_t *p_btif_cb )
@@ -403,8 +691,121 @@ static void btif_gattc_update_properties ( btif_gattc_cb_t *p_btif_cb )
         btif_dm_update_ble_remote_properties( p_btif_cb->bd_addr.address,   bdname.name,
                                                p_btif_cb->device_type);
     }
+}
 
-    btif_storage_set_remote_addr_type( &p_btif_cb->bd_addr, p_btif_cb->addr_type);
+/*******************************************************************************
+**
+** Function         btif_gattc_process_scan_result
+**
+** Description      Updates the observed device and passes a scan report up
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_gattc_process_scan_result(btif_gattc_cb_t *p_btif_cb)
+{
+    btif_gattc_dev_t *p_dev = btif_gattc_find_bdaddr(p_btif_cb->bd_addr.address);
+    uint8_t remote_name_len;
+    uint8_t *p_eir_remote_name=NULL;
+    uint8_t dmt_supported;
+
+    p_dev_cb->num_reports++;
+
+    if (p_dev == NULL)
+    {
+        p_dev = btif_gattc_add_remote_bdaddr(p_btif_cb->bd_addr.address,
+                                             p_btif_cb->addr_type);
+        p_dev->device_type = p_btif_cb->device_type;
+        btif_gattc_update_observed_dev(p_dev);
+    }
+
+    if (!p_dev->props_reported)
+    {
+        p_eir_remote_name = BTA_CheckEirData(p_btif_cb->value,
+                                     BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
+
+        if (p_eir_remote_name == NULL)
+        {
+            p_eir_remote_name = BTA_CheckEirData(p_btif_cb->value,
+                            BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
+        }
+
+        if ((p_btif_cb->addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name))
+        {
+            p_dev->props_reported = TRUE;
+            btif_gattc_update_properties(p_btif_cb);
+            btif_gattc_update_observed_dev(p_dev);
+        }
+    }
+
+    /* Only properties that changed since the last report get persisted */
+    dmt_supported = (p_btif_cb->device_type == BT_DEVICE_TYPE_DUMO) &&
+                    (p_btif_cb->flag & BTA_BLE_DMT_CONTROLLER_SPT) &&
+                    (p_btif_cb->flag & BTA_BLE_DMT_HOST_SPT);
+
+    if (p_dev->device_type != p_btif_cb->device_type ||
+        p_dev->addr_type != p_btif_cb->addr_type ||
+        (dmt_supported && !p_dev->dmt_supported))
+    {
+        p_dev->device_type = p_btif_cb->device_type;
+        p_dev->addr_type = p_btif_cb->addr_type;
+        p_dev->dmt_supported |= dmt_supported;
+        btif_gattc_update_observed_dev(p_dev);
+    }
+
+    HAL_CBACK(bt_gatt_callbacks, client->scan_result_cb,
+              &p_btif_cb->bd_addr, p_btif_cb->rssi, p_btif_cb->value);
+    btif_gattc_scan_cb.stats.delivered++;
+}
+
+static void btif_gattc_send_scan_drain(void)
+{
+    if (btif_transfer_context(btif_gattc_upstreams_evt, BTIF_GATT_OBSERVE_EVT,
+                              NULL, 0, NULL) != BT_STATUS_SUCCESS)
+    {
+        /* retried with the next report */
+        GKI_disable();
+        btif_gattc_scan_cb.drain_pending = FALSE;
+        GKI_enable();
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btif_gattc_deliver_scan_results
+**
+** Description      Passes up the queued scan reports, at most
+**                  BTIF_GATT_SCAN_BATCH_MAX of them before yielding to other
+**                  btif events. Reports queued meanwhile are picked up by this
+**                  drain or by the next one, which is sent from here or by
+**                  bta_scan_results_cb.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_gattc_deliver_scan_results(void)
+{
+    btif_gattc_scan_cb_t *p_cb = &btif_gattc_scan_cb;
+    btif_gattc_cb_t *p_btif_cb;
+    BOOLEAN more;
+    int n;
+
+    for (n = 0; n < BTIF_GATT_SCAN_BATCH_MAX; n++)
+    {
+        if ((p_btif_cb = (btif_gattc_cb_t *) GKI_dequeue(&p_cb->report_q)) == NULL)
+            break;
+        btif_gattc_process_scan_result(p_btif_cb);
+        GKI_freebuf(p_btif_cb);
+    }
+    p_cb->stats.batches++;
+
+    GKI_disable();
+    more = !GKI_queue_is_empty(&p_cb->report_q);
+    p_cb->drain_pending = more;
+    GKI_enable();
+
+    if (more)
+        btif_gattc_send_scan_drain();
 }
 
 static void btif_gattc_upstreams_evt(uint16_t event, char* p_param)
@@ -561,53 +962,12 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param)
             break;
 
         case BTIF_GATT_OBSERVE_EVT:
-        {
-            btif_gattc_cb_t *p_btif_cb = (btif_gattc_cb_t*) p_param;
-            uint8_t remote_name_len;
-            uint8_t *p_eir_remote_name=NULL;
-            bt_device_type_t dev_type;
-            bt_property_t properties;
-
-            p_eir_remote_name = BTA_CheckEirData(p_btif_cb->value,
-                                         BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
-
-            if (p_eir_remote_name == NULL)
-            {
-                p_eir_remote_name = BTA_CheckEirData(p_btif_cb->value,
-                                BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
-            }
-
-            if ((p_btif_cb->addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name))
-            {
-               if (!btif_gattc_find_bdaddr(p_btif_cb->bd_addr.address))
-               {
-                  static const char* exclude_filter[] =
-                        {"LinkKey", "LE_KEY_PENC", "LE_KEY_PID", "LE_KEY_PCSRK", "LE_KEY_LENC", "LE_KEY_LCSRK"};
-
-                  btif_gattc_add_remote_bdaddr(p_btif_cb->bd_addr.address, p_btif_cb->addr_type);
-                  btif_gattc_update_properties(p_btif_cb);
-                  btif_config_filter_remove("Remote", exclude_filter, sizeof(exclude_filter)/sizeof(char*),
-                  BTIF_STORAGE_MAX_ALLOWED_REMOTE_DEVICE);
-               }
-
-            }
-
-            if (( p_btif_cb->device_type == BT_DEVICE_TYPE_DUMO)&&
-               (p_btif_cb->flag & BTA_BLE_DMT_CONTROLLER_SPT) &&
-               (p_btif_cb->flag & BTA_BLE_DMT_HOST_SPT))
-             {
-                btif_storage_set_dmt_support_type (&(p_btif_cb->bd_addr), TRUE);
-             }
-
-             dev_type =  p_btif_cb->device_type;
-             BTIF_STORAGE_FILL_PROPERTY(&properties,
-                        BT_PROPERTY_TYPE_OF_DEVICE, sizeof(dev_type), &dev_type);
-             btif_storage_set_remote_device_property(&(p_btif_cb->bd_addr), &properties);
+            btif_gattc_deliver_scan_results();
+            break;
 
-            HAL_CBACK(bt_gatt_callbacks, client->scan_result_cb,
-                      &p_btif_cb->bd_addr, p_btif_cb->rssi, p_btif_cb->value);
+        case BTIF_GATT_OBSERVE_FLUSH_EVT:
+            btif_gattc_flush_observed_dev();
             break;
-        }
 
         case BTIF_GATTC_RSSI_EVT:
         {
@@ -800,8 +1160,30 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param)
 
 static void bta_gattc_cback(tBTA_GATTC_EVT event, tBTA_GATTC *p_data)
 {
-    bt_status_t status = btif_transfer_context(btif_gattc_upstreams_evt,
+    bt_status_t status;
+
+    if (event == BTA_GATTC_NOTIF_EVT)
+    {
+        /* Notifications are the bulk of GATT client traffic; build the event in
+        ** the message directly and only copy the part of the value in use. */
+        tBTA_GATTC *p_msg = (tBTA_GATTC *) btif_context_msg_alloc(btif_gattc_upstreams_evt,
+                                                    (uint16_t) event, sizeof(tBTA_GATTC));
+        int copy_len = offsetof(tBTA_GATTC_NOTIFY, value) + p_data->notify.len;
+
+        if (p_msg != NULL)
+        {
+            memcpy(&p_msg->notify, &p_data->notify, copy_len);
+            p_msg->notify.is_notify = p_data->notify.is_notify;
+            BTIF_CONTEXT_MSG_COPIED(p_msg, copy_len);
+            btif_context_msg_send((char *) p_msg);
+        }
+        status = (p_msg != NULL) ? BT_STATUS_SUCCESS : BT_STATUS_NOMEM;
+    }
+    else
+    {
+        status = btif_transfer_context(btif_gattc_upstreams_evt,
                     (uint16_t) event, (void*) p_data, sizeof(tBTA_GATTC), btapp_gattc_req_data);
+    }
     ASSERTC(status == BT_STATUS_SUCCESS, "Context transfer failed!", status);
 }
 
@@ -960,27 +1342,40 @@ static void bta_batch_scan_reports_cb(tBTA_DM_BLE_REF_VALUE ref_value, UINT8 rep
 
 static void bta_scan_results_cb (tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data)
 {
-    btif_gattc_cb_t btif_cb;
+    btif_gattc_cb_t *p_btif_cb;
+    BOOLEAN send;
     uint8_t len;
 
     switch (event)
     {
         case BTA_DM_INQ_RES_EVT:
         {
-            bdcpy(btif_cb.bd_addr.address, p_data->inq_res.bd_addr);
-            btif_cb.device_type = p_data->inq_res.device_type;
-            btif_cb.rssi = p_data->inq_res.rssi;
-            btif_cb.addr_type = p_data->inq_res.ble_addr_type;
-            btif_cb.flag = p_data->inq_res.flag;
-            if (p_data->inq_res.p_eir)
+            if (p_data->inq_res.p_eir &&
+                BTA_CheckEirData(p_data->inq_res.p_eir, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &len))
             {
-                memcpy(btif_cb.value, p_data->inq_res.p_eir, 62);
-                if (BTA_CheckEirData(p_data->inq_res.p_eir, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE,
-                                      &len))
-                {
-                    p_data->inq_res.remt_name_not_required  = TRUE;
-                }
+                p_data->inq_res.remt_name_not_required = TRUE;
+            }
+
+            if (!btif_gattc_scan_filter(p_data->inq_res.bd_addr, p_data->inq_res.rssi,
+                                        p_data->inq_res.p_eir, p_data->inq_res.p_eir ? 62 : 0))
+                return;
+
+            /* Queued for the btif task, which takes all reports queued by
+            ** the time it runs in one go */
+            p_btif_cb = (btif_gattc_cb_t *) GKI_getbuf(sizeof(btif_gattc_cb_t));
+            if (p_btif_cb == NULL)
+            {
+                BTIF_TRACE_ERROR("%s : out of buffers, scan result dropped", __FUNCTION__);
+                return;
             }
+
+            bdcpy(p_btif_cb->bd_addr.address, p_data->inq_res.bd_addr);
+            p_btif_cb->device_type = p_data->inq_res.device_type;
+            p_btif_cb->rssi = p_data->inq_res.rssi;
+            p_btif_cb->addr_type = p_data->inq_res.ble_addr_type;
+            p_btif_cb->flag = p_data->inq_res.flag;
+            if (p_data->inq_res.p_eir)
+                memcpy(p_btif_cb->value, p_data->inq_res.p_eir, 62);
         }
         break;
 
@@ -995,8 +1390,16 @@ static void bta_scan_results_cb (tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_dat
         BTIF_TRACE_WARNING("%s : Unknown event 0x%x", __FUNCTION__, event);
         return;
     }
-    btif_transfer_context(btif_gattc_upstreams_evt, BTIF_GATT_OBSERVE_EVT,
-                                 (char*) &btif_cb, sizeof(btif_gattc_cb_t), NULL);
+
+    GKI_enqueue(&btif_gattc_scan_cb.report_q, p_btif_cb);
+
+    GKI_disable();
+    send = !btif_gattc_scan_cb.drain_pending;
+    btif_gattc_scan_cb.drain_pending = TRUE;
+    GKI_enable();
+
+    if (send)
+        btif_gattc_send_scan_drain();
 }
 
 static void bta_track_adv_event_cb(int filt_index, tBLE_ADDR_TYPE addr_type, BD_ADDR bda,
@@ -1101,12 +1504,23 @@ static void btgattc_handle_event(uint16_t event, char* p_param)
 
         case BTIF_GATTC_SCAN_START:
             btif_gattc_init_dev_cb();
+            btif_gattc_scan_cb.clear_filter = TRUE;
             BTA_DmBleObserve(TRUE, 0, bta_scan_results_cb);
             break;
 
         case BTIF_GATTC_SCAN_STOP:
+        {
+            btif_gattc_scan_stats_t stats;
+
             BTA_DmBleObserve(FALSE, 0, 0);
+            btif_gattc_flush_observed_dev();
+
+            btif_gattc_get_scan_stats(&stats);
+            BTIF_TRACE_DEBUG("%s scan reports: %u received, %u suppressed, %u delivered in %u batches",
+                             __FUNCTION__, stats.received, stats.suppressed, stats.delivered,
+                             stats.batches);
             break;
+        }
 
         case BTIF_GATTC_OPEN:
         {
@@ -593,8 +593,6 @@ void btif_hh_remove_device(bt_bdaddr_t bd_addr)
         BTIF_TRACE_WARNING("%s: device_num = 0", __FUNCTION__);
     }
 
-    p_dev->hh_keep_polling = 0;
-    p_dev->hh_poll_thread_id = -1;
     BTIF_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
     if (p_dev->fd >= 0) {
         bta_hh_co_destroy(p_dev->fd);
@@ -1833,8 +1831,6 @@ static void  cleanup( void )
              BTIF_TRACE_DEBUG("%s: Closing uhid fd = %d", __FUNCTION__, p_dev->fd);
              bta_hh_co_destroy(p_dev->fd);
              p_dev->fd = -1;
-             p_dev->hh_keep_polling = 0;
-             p_dev->hh_poll_thread_id = -1;
          }
      }
 }
@@ -83,7 +83,9 @@
 #if (BTA_AV_SINK_INCLUDED == TRUE)
 OI_CODEC_SBC_DECODER_CONTEXT context;
 OI_UINT32 contextData[CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS)];
-OI_INT16 pcmData[15*SBC_MAX_SAMPLES_PER_FRAME*SBC_MAX_CHANNELS];
+/* SBC frames decoded into pcmData per sink tick at most */
+#define BTIF_SINK_PCM_MAX_FRAMES 15
+OI_INT16 pcmData[BTIF_SINK_PCM_MAX_FRAMES*SBC_MAX_SAMPLES_PER_FRAME*SBC_MAX_CHANNELS];
 #endif
 
 /*****************************************************************************
@@ -156,6 +158,13 @@ enum {
 #define A2DP_DATA_READ_POLL_MS    (BTIF_MEDIA_TIME_TICK / 2)
 #define BTIF_SINK_MEDIA_TIME_TICK                (20 * BTIF_MEDIA_NUM_TICK)
 
+/* Sink jitter buffer, in sink ticks worth of queued SBC frames. Output
+   (re)starts once the target is queued; an underrun deepens the target and
+   BTIF_SINK_JITTER_DECAY_TICKS ticks without one make it shallower again */
+#define BTIF_SINK_JITTER_TICKS_MIN               2
+#define BTIF_SINK_JITTER_TICKS_MAX               6
+#define BTIF_SINK_JITTER_DECAY_TICKS             500
+
 
 /* buffer pool */
 #define BTIF_MEDIA_AA_POOL_ID GKI_POOL_ID_3
@@ -173,6 +182,16 @@ enum {
 #define BTIF_MEDIA_BITRATE_STEP 5
 #endif
 
+/* Live bitpool adaptation: step down while the tx queue backs up, hold at
+   least BTIF_MEDIA_BITPOOL_DOWN_TICKS between steps, and step back up after
+   BTIF_MEDIA_BITPOOL_UP_TICKS ticks with a drained queue. The peer min and
+   the negotiated bitpool bound it, so no renegotiation is needed */
+#ifndef BTIF_MEDIA_BITPOOL_STEP
+#define BTIF_MEDIA_BITPOOL_STEP 4
+#endif
+#define BTIF_MEDIA_BITPOOL_DOWN_TICKS 5
+#define BTIF_MEDIA_BITPOOL_UP_TICKS 100
+
 /* Middle quality quality setting @ 44.1 khz */
 #define DEFAULT_SBC_BITRATE 328
 
@@ -217,6 +236,13 @@ static UINT32 a2dp_media_task_stack[(A2DP_MEDIA_TASK_STACK_SIZE + 3) / 4];
 #define MAX_PCM_FRAME_NUM_PER_TICK     10
 #define RESET_RATE_COUNTER_THRESHOLD_MS    2000
 
+/* The encoder paces the tx queue towards a target depth that covers the
+   measured media tick jitter: enough packets for one tick plus twice the
+   smoothed jitter, clamped to [A2DP_TX_Q_TARGET_MIN, MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ).
+   Frames not encoded while above target stay in the rate counter. */
+#define A2DP_TX_Q_TARGET_MIN           2
+#define A2DP_TICK_JITTER_SHIFT         3   /* 1/8 smoothing of the jitter estimate */
+
 //#define BTIF_MEDIA_VERBOSE_ENABLED
 /* In case of A2DP SINK, we will delay start by 5 AVDTP Packets*/
 #define MAX_A2DP_DELAYED_START_FRAME_COUNT 1
@@ -256,6 +282,12 @@ typedef struct
     UINT32 max_counter_enter;
     UINT32 overflow_count;
     BOOLEAN overflow;
+    UINT32 tick_jitter_us;  /* smoothed deviation of the tx tick from its period */
+    UINT32 pkts_per_tick;   /* smoothed packets queued per tick, 4 fractional bits */
+    UINT32 tx_q_target;     /* tx queue depth the encoder paces towards */
+    UINT32 tx_q_max;        /* deepest tx queue seen */
+    UINT32 underrun_count;  /* encodes that ran out of pcm from the audio hal */
+    UINT32 drop_count;      /* pcm frames dropped on rate counter reset */
 } tBTIF_AV_MEDIA_FEEDINGS_PCM_STATE;
 
 
@@ -286,6 +318,14 @@ typedef struct
     UINT8 peer_sep;
     BOOLEAN data_channel_open;
     UINT8   frames_to_process;
+    UINT8   rx_jitter_ticks;  /* sink jitter buffer target */
+    BOOLEAN rx_prebuffering;  /* output held until the jitter buffer refills */
+    UINT16  rx_clean_ticks;   /* sink ticks since the last underrun */
+    UINT32  rx_underrun_count;
+    SINT16  max_bitpool; /* bitpool from the encoder update, ceiling for adaptation */
+    SINT16  min_bitpool; /* peer minimum bitpool */
+    UINT16  bitpool_down_ticks;
+    UINT16  bitpool_up_ticks;
 
     UINT32  sample_rate;
     UINT8   channel_count;
@@ -312,6 +352,11 @@ static tBTIF_MEDIA_CB btif_media_cb;
 static int media_task_running = MEDIA_TASK_STATE_OFF;
 static UINT64 last_frame_us = 0;
 
+/* The SBC encoder keeps its filter history in globals, shared with mSBC
+ * encoding for SCO over HCI in BTU task context */
+static pthread_mutex_t btif_media_sbc_enc_lock = PTHREAD_MUTEX_INITIALIZER;
+static SBC_ENC_PARAMS *btif_media_sbc_enc_owner;
+
 
 /*****************************************************************************
  **  Local functions
@@ -347,7 +392,8 @@ static void btif_media_task_handle_cmd(BT_HDR *p_msg);
 static void btif_media_task_handle_media(BT_HDR*p_msg);
 /* Handle incoming media packets A2DP SINK streaming*/
 #if (BTA_AV_SINK_INCLUDED == TRUE)
-static void btif_media_task_handle_inc_media(tBT_SBC_HDR*p_msg);
+static int btif_media_task_handle_inc_media(tBT_SBC_HDR *p_msg, OI_INT16 **pp_pcm,
+                                            UINT32 *p_avail_bytes);
 #endif
 
 #if (BTA_AV_INCLUDED == TRUE)
@@ -1268,68 +1314,112 @@ void btif_a2dp_set_audio_focus_state(btif_media_AudioFocus_state state)
  **
  ** Function         btif_media_task_avk_handle_timer
  **
- ** Description
+ ** Description      Decode one tick worth of SBC frames, across as many queued
+ **                  packets as needed, and write the PCM out in one go. The
+ **                  number of queued frames is kept around the jitter target.
  **
  ** Returns          void
  **
  *******************************************************************************/
 static void btif_media_task_avk_handle_timer ( void )
 {
-    UINT8 count;
     tBT_SBC_HDR *p_msg;
+    OI_INT16 *pcmDataPointer = pcmData;
+    UINT32 availPcmBytes = sizeof(pcmData);
+    BOOLEAN discard;
     int num_sbc_frames;
     int num_frames_to_process;
+    int queued_frames = 0;
+    int target;
+
+    if (btif_media_cb.rx_flush == TRUE)
+    {
+        btif_media_flush_q(&(btif_media_cb.RxSbcQ));
+        return;
+    }
+
+    /* every queued frame covers the same number of samples, so the frame count
+       is the media timestamp span held in the queue */
+    p_msg = (tBT_SBC_HDR *)GKI_getfirst(&(btif_media_cb.RxSbcQ));
+    while (p_msg != NULL)
+    {
+        queued_frames += p_msg->num_frames_to_be_processed;
+        p_msg = (tBT_SBC_HDR *)GKI_getnext(p_msg);
+    }
+
+    num_frames_to_process = btif_media_cb.frames_to_process;
+    target = num_frames_to_process * btif_media_cb.rx_jitter_ticks;
 
-    count = btif_media_cb.RxSbcQ.count;
-    if (0 == count)
+    if (btif_media_cb.rx_prebuffering)
+    {
+        if (queued_frames < target)
+            return;
+        APPL_TRACE_DEBUG("btif_media_task_avk_handle_timer: %d frames buffered", queued_frames);
+        btif_media_cb.rx_prebuffering = FALSE;
+    }
+    else if (queued_frames < num_frames_to_process)
     {
-        APPL_TRACE_DEBUG("  QUE  EMPTY ");
+        /* play what is left and refill a deeper buffer before resuming */
+        btif_media_cb.rx_underrun_count++;
+        btif_media_cb.rx_clean_ticks = 0;
+        btif_media_cb.rx_prebuffering = TRUE;
+        if (btif_media_cb.rx_jitter_ticks < BTIF_SINK_JITTER_TICKS_MAX)
+            btif_media_cb.rx_jitter_ticks++;
+        APPL_TRACE_DEBUG("btif_media_task_avk_handle_timer: underrun, %d frames, target %d ticks",
+                queued_frames, btif_media_cb.rx_jitter_ticks);
+        num_frames_to_process = queued_frames;
     }
     else
     {
-        if (btif_media_cb.rx_flush == TRUE)
+        /* drain one extra frame per tick to bring a burst back to the target */
+        if (queued_frames > target + num_frames_to_process)
+            num_frames_to_process++;
+
+        if ((++btif_media_cb.rx_clean_ticks >= BTIF_SINK_JITTER_DECAY_TICKS) &&
+            (btif_media_cb.rx_jitter_ticks > BTIF_SINK_JITTER_TICKS_MIN))
         {
-            btif_media_flush_q(&(btif_media_cb.RxSbcQ));
-            return;
+            btif_media_cb.rx_jitter_ticks--;
+            btif_media_cb.rx_clean_ticks = 0;
         }
+    }
 
-        num_frames_to_process = btif_media_cb.frames_to_process;
-        APPL_TRACE_DEBUG(" Process Frames + ");
+    if (num_frames_to_process > BTIF_SINK_PCM_MAX_FRAMES)
+        num_frames_to_process = BTIF_SINK_PCM_MAX_FRAMES;
 
-        do
-        {
-            p_msg = (tBT_SBC_HDR *)GKI_getfirst(&(btif_media_cb.RxSbcQ));
-            if (p_msg == NULL)
-                return;
-            num_sbc_frames  = p_msg->num_frames_to_be_processed; /* num of frames in Que Packets */
-            APPL_TRACE_DEBUG(" Frames left in topmost packet %d", num_sbc_frames);
-            APPL_TRACE_DEBUG(" Remaining frames to process in tick %d", num_frames_to_process);
-            APPL_TRACE_DEBUG(" Num of Packets in Que %d", btif_media_cb.RxSbcQ.count);
+    /* frames are still consumed when nobody listens, to keep the timing */
+    discard = (btif_media_cb.peer_sep == AVDT_TSEP_SNK);
+#ifndef AVK_BACKPORT
+    discard |= !btif_media_cb.data_channel_open;
+#endif
 
-            if ( num_sbc_frames > num_frames_to_process) /*  Que Packet has more frames*/
-            {
-                 p_msg->num_frames_to_be_processed= num_frames_to_process;
-                 btif_media_task_handle_inc_media(p_msg);
-                 p_msg->num_frames_to_be_processed = num_sbc_frames - num_frames_to_process;
-                 num_frames_to_process = 0;
-                 break;
-            }
-            else                                        /*  Que packet has less frames */
-            {
-                btif_media_task_handle_inc_media(p_msg);
-                p_msg = (tBT_SBC_HDR *)GKI_dequeue(&(btif_media_cb.RxSbcQ));
-                if( p_msg == NULL )
-                {
-                     APPL_TRACE_ERROR("Insufficient data in que ");
-                     break;
-                }
-                num_frames_to_process = num_frames_to_process - p_msg->num_frames_to_be_processed;
-                GKI_freebuf(p_msg);
-            }
-        }while(num_frames_to_process > 0);
+    while ((num_frames_to_process > 0) &&
+           ((p_msg = (tBT_SBC_HDR *)GKI_getfirst(&(btif_media_cb.RxSbcQ))) != NULL))
+    {
+        num_sbc_frames = p_msg->num_frames_to_be_processed; /* num of frames in Que Packets */
 
-        APPL_TRACE_DEBUG(" Process Frames - ");
+        if (num_sbc_frames > num_frames_to_process) /*  Que Packet has more frames*/
+        {
+            p_msg->num_frames_to_be_processed = num_frames_to_process;
+            if (!discard)
+                btif_media_task_handle_inc_media(p_msg, &pcmDataPointer, &availPcmBytes);
+            p_msg->num_frames_to_be_processed = num_sbc_frames - num_frames_to_process;
+            break;
+        }
+
+        if (!discard)
+            btif_media_task_handle_inc_media(p_msg, &pcmDataPointer, &availPcmBytes);
+        num_frames_to_process -= num_sbc_frames;
+        GKI_freebuf(GKI_dequeue(&(btif_media_cb.RxSbcQ)));
     }
+
+    if (availPcmBytes == sizeof(pcmData))
+        return;
+
+#ifdef AVK_BACKPORT
+    btWriteData((void*)pcmData, (sizeof(pcmData) - availPcmBytes));
+#else
+    UIPC_Send(UIPC_CH_ID_AV_AUDIO, 0, (UINT8 *)pcmData, (sizeof(pcmData) - availPcmBytes));
+#endif
 }
 #endif
 
@@ -1613,60 +1703,41 @@ static void btif_media_task_handle_cmd(BT_HDR *p_msg)
  **
  ** Function         btif_media_task_handle_inc_media
  **
- ** Description
+ ** Description      Decode num_frames_to_be_processed frames of the packet,
+ **                  appending the PCM at *pp_pcm.
  **
- ** Returns          void
+ ** Returns          number of frames decoded
  **
  *******************************************************************************/
-static void btif_media_task_handle_inc_media(tBT_SBC_HDR*p_msg)
+static int btif_media_task_handle_inc_media(tBT_SBC_HDR *p_msg, OI_INT16 **pp_pcm,
+                                            UINT32 *p_avail_bytes)
 {
     UINT8 *sbc_start_frame = ((UINT8*)(p_msg + 1) + p_msg->offset + 1);
     int count;
-    UINT32 pcmBytes, availPcmBytes;
-    OI_INT16 *pcmDataPointer = pcmData; /*Will be overwritten on next packet receipt*/
+    UINT32 pcmBytes;
     OI_STATUS status;
     int num_sbc_frames = p_msg->num_frames_to_be_processed;
     UINT32 sbc_frame_len = p_msg->len - 1;
-#ifdef AVK_BACKPORT
-    int retwriteAudioTrack = 0;
-#endif
-    availPcmBytes = 2*sizeof(pcmData);
-
-    if ((btif_media_cb.peer_sep == AVDT_TSEP_SNK) || (btif_media_cb.rx_flush))
-    {
-        APPL_TRACE_DEBUG(" State Changed happened in this tick ");
-        return;
-    }
-
-#ifndef AVK_BACKPORT
-    // ignore data if no one is listening
-    if (!btif_media_cb.data_channel_open)
-        return;
-#endif
 
     APPL_TRACE_DEBUG("Number of sbc frames %d, frame_len %d", num_sbc_frames, sbc_frame_len);
 
     for(count = 0; count < num_sbc_frames && sbc_frame_len != 0; count ++)
     {
-        pcmBytes = availPcmBytes;
+        pcmBytes = *p_avail_bytes;
         status = OI_CODEC_SBC_DecodeFrame(&context, (const OI_BYTE**)&sbc_start_frame,
                                                         (OI_UINT32 *)&sbc_frame_len,
-                                                        (OI_INT16 *)pcmDataPointer,
+                                                        (OI_INT16 *)*pp_pcm,
                                                         (OI_UINT32 *)&pcmBytes);
         if (!OI_SUCCESS(status)) {
             APPL_TRACE_ERROR("Decoding failure: %d\n", status);
             break;
         }
-        availPcmBytes -= pcmBytes;
-        pcmDataPointer += pcmBytes/2;
+        *p_avail_bytes -= pcmBytes;
+        *pp_pcm += pcmBytes/2;
         p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
         p_msg->len = sbc_frame_len + 1;
     }
-#ifdef AVK_BACKPORT
-    retwriteAudioTrack = btWriteData((void*)pcmData, (2*sizeof(pcmData) - availPcmBytes));
-#else
-    UIPC_Send(UIPC_CH_ID_AV_AUDIO, 0, (UINT8 *)pcmData, (2*sizeof(pcmData) - availPcmBytes));
-#endif
+    return count;
 }
 #endif
 
@@ -1894,6 +1965,42 @@ static void btif_media_task_aa_tx_flush(BT_HDR *p_msg)
     UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
 }
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_sbc_enc_acquire
+ **
+ ** Description      Take the SBC encoder for p_enc. The encoder state shared
+ **                  by all instances is reset if another instance used it last.
+ **                  Must be paired with btif_media_sbc_enc_release.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_sbc_enc_acquire(SBC_ENC_PARAMS *p_enc)
+{
+    pthread_mutex_lock(&btif_media_sbc_enc_lock);
+
+    if (btif_media_sbc_enc_owner != p_enc)
+    {
+        SBC_Encoder_Reset(p_enc);
+        btif_media_sbc_enc_owner = p_enc;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_sbc_enc_release
+ **
+ ** Description      Give back the SBC encoder taken by btif_media_sbc_enc_acquire
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_sbc_enc_release(void)
+{
+    pthread_mutex_unlock(&btif_media_sbc_enc_lock);
+}
+
 /*******************************************************************************
  **
  ** Function       btif_media_task_enc_init
@@ -1935,7 +2042,9 @@ static void btif_media_task_enc_init(BT_HDR *p_msg)
             btif_media_cb.encoder.s16SamplingFreq);
 
     /* Reset entirely the SBC encoder */
+    btif_media_sbc_enc_acquire(&(btif_media_cb.encoder));
     SBC_Encoder_Init(&(btif_media_cb.encoder));
+    btif_media_sbc_enc_release();
     APPL_TRACE_DEBUG("btif_media_task_enc_init bit pool %d", btif_media_cb.encoder.s16BitPool);
 }
 
@@ -2086,7 +2195,15 @@ static void btif_media_task_enc_update(BT_HDR *p_msg)
                 btif_media_cb.encoder.u16BitRate, btif_media_cb.encoder.s16BitPool);
 
         /* make sure we reinitialize encoder with new settings */
+        btif_media_sbc_enc_acquire(&(btif_media_cb.encoder));
         SBC_Encoder_Init(&(btif_media_cb.encoder));
+        btif_media_sbc_enc_release();
+
+        /* restart the live adaptation from the negotiated bitpool */
+        btif_media_cb.max_bitpool = btif_media_cb.encoder.s16BitPool;
+        btif_media_cb.min_bitpool = pUpdateAudio->MinBitPool;
+        btif_media_cb.bitpool_down_ticks = 0;
+        btif_media_cb.bitpool_up_ticks = 0;
     }
 }
 
@@ -2161,7 +2278,9 @@ static void btif_media_task_pcm2sbc_init(tBTIF_MEDIA_INIT_AUDIO_FEEDING * p_feed
                 btif_media_cb.encoder.s16AllocationMethod, btif_media_cb.encoder.u16BitRate,
                 btif_media_cb.encoder.s16SamplingFreq);
 
+        btif_media_sbc_enc_acquire(&(btif_media_cb.encoder));
         SBC_Encoder_Init(&(btif_media_cb.encoder));
+        btif_media_sbc_enc_release();
     }
     else
     {
@@ -2269,6 +2388,8 @@ void btif_a2dp_set_peer_sep(UINT8 sep) {
  *******************************************************************************/
 static void btif_media_task_aa_handle_stop_decoding(void )
 {
+    APPL_TRACE_EVENT("btif_media_task_aa_handle_stop_decoding: %u underruns, jitter target %d ticks",
+            btif_media_cb.rx_underrun_count, btif_media_cb.rx_jitter_ticks);
     btif_media_cb.is_rx_timer = FALSE;
     GKI_stop_timer(BTIF_MEDIA_AVK_TASK_TIMER_ID);
 #ifdef AVK_BACKPORT
@@ -2294,6 +2415,9 @@ static void btif_media_task_aa_handle_start_decoding(void )
     btStartTrack();
 #endif
     btif_media_cb.is_rx_timer = TRUE;
+    btif_media_cb.rx_prebuffering = TRUE;
+    if (btif_media_cb.rx_jitter_ticks < BTIF_SINK_JITTER_TICKS_MIN)
+        btif_media_cb.rx_jitter_ticks = BTIF_SINK_JITTER_TICKS_MIN;
     GKI_start_timer(BTIF_MEDIA_AVK_TASK_TIMER_ID, GKI_MS_TO_TICKS(BTIF_SINK_MEDIA_TIME_TICK), TRUE);
 }
 
@@ -2345,6 +2469,10 @@ static void btif_media_task_aa_handle_decoder_reset(BT_HDR *p_msg)
     btif_media_cb.rx_flush = FALSE;
 #endif
 
+    btif_media_cb.rx_jitter_ticks = BTIF_SINK_JITTER_TICKS_MIN;
+    btif_media_cb.rx_clean_ticks = 0;
+    btif_media_cb.rx_underrun_count = 0;
+
     APPL_TRACE_DEBUG("Reset to sink role");
     status = OI_CODEC_SBC_DecoderReset(&context, contextData, sizeof(contextData), 2, 2, FALSE);
     if (!OI_SUCCESS(status)) {
@@ -2475,6 +2603,12 @@ static void btif_media_task_feeding_state_reset(void)
         btif_media_cb.media_feeding_state.pcm.overflow_count,
         btif_media_cb.media_feeding_state.pcm.max_counter_enter,
         btif_media_cb.media_feeding_state.pcm.max_counter_exit);
+    APPL_TRACE_WARNING("tx queue max %d, target %d, underrun %d, dropped frames %d, jitter %d us",
+        btif_media_cb.media_feeding_state.pcm.tx_q_max,
+        btif_media_cb.media_feeding_state.pcm.tx_q_target,
+        btif_media_cb.media_feeding_state.pcm.underrun_count,
+        btif_media_cb.media_feeding_state.pcm.drop_count,
+        btif_media_cb.media_feeding_state.pcm.tick_jitter_us);
 
     /* By default, just clear the entire state */
     memset(&btif_media_cb.media_feeding_state, 0, sizeof(btif_media_cb.media_feeding_state));
@@ -2564,6 +2698,41 @@ static void btif_media_task_aa_stop_tx(void)
     btif_media_task_feeding_state_reset();
 }
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_update_tx_q_target
+ **
+ ** Description      Track the tx tick jitter and the tx queue state, and update
+ **                  the queue depth the encoder paces towards
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_update_tx_q_target(UINT32 us_this_tick)
+{
+    tBTIF_AV_MEDIA_FEEDINGS_PCM_STATE *p_pcm = &btif_media_cb.media_feeding_state.pcm;
+    UINT32 tick_us = BTIF_MEDIA_TIME_TICK * 1000;
+    UINT32 dev_us = (us_this_tick > tick_us) ? (us_this_tick - tick_us) : (tick_us - us_this_tick);
+    UINT32 target;
+
+    if (btif_media_cb.TxAaQ.count > p_pcm->tx_q_max)
+        p_pcm->tx_q_max = btif_media_cb.TxAaQ.count;
+
+    /* the smoothed values use integer shifts so the estimate settles in a few ticks */
+    if (p_pcm->tick_jitter_us == 0)
+        p_pcm->tick_jitter_us = dev_us;
+    else
+        p_pcm->tick_jitter_us += ((INT32)dev_us - (INT32)p_pcm->tick_jitter_us) >> A2DP_TICK_JITTER_SHIFT;
+
+    /* one tick worth of packets, plus what arrives during twice the jitter */
+    target = (p_pcm->pkts_per_tick * (tick_us + 2 * p_pcm->tick_jitter_us) / tick_us + 15) >> 4;
+    if (target < A2DP_TX_Q_TARGET_MIN)
+        target = A2DP_TX_Q_TARGET_MIN;
+    if (target >= MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ)
+        target = MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ - 1;
+    p_pcm->tx_q_target = target;
+}
+
 /*******************************************************************************
  **
  ** Function         btif_get_num_aa_frame
@@ -2595,7 +2764,22 @@ static UINT8 btif_get_num_aa_frame(void)
             btif_media_cb.media_feeding_state.pcm.counter +=
                                 btif_media_cb.media_feeding_state.pcm.bytes_per_tick *
                                 us_this_tick / (BTIF_MEDIA_TIME_TICK * 1000);
-            if ((!btif_media_cb.media_feeding_state.pcm.overflow) ||
+
+            btif_media_update_tx_q_target(us_this_tick);
+
+            if ((!btif_media_cb.media_feeding_state.pcm.overflow) &&
+                (btif_media_cb.TxAaQ.count >= btif_media_cb.media_feeding_state.pcm.tx_q_target)) {
+                /* the link has not drained what is queued, let it catch up first */
+                UINT32 reset_rate_bytes = btif_media_cb.media_feeding_state.pcm.bytes_per_tick *
+                                    (RESET_RATE_COUNTER_THRESHOLD_MS / BTIF_MEDIA_TIME_TICK);
+                if (btif_media_cb.media_feeding_state.pcm.counter > reset_rate_bytes) {
+                    btif_media_cb.media_feeding_state.pcm.drop_count +=
+                        btif_media_cb.media_feeding_state.pcm.counter / pcm_bytes_per_frame;
+                    btif_media_cb.media_feeding_state.pcm.counter = 0;
+                    APPL_TRACE_WARNING("%s() - link stalled, reset rate counter", __FUNCTION__);
+                }
+                result = 0;
+            } else if ((!btif_media_cb.media_feeding_state.pcm.overflow) ||
                 (btif_media_cb.TxAaQ.count < A2DP_PACKET_COUNT_LOW_WATERMARK)) {
                 if (btif_media_cb.media_feeding_state.pcm.overflow) {
                     btif_media_cb.media_feeding_state.pcm.overflow = FALSE;
@@ -2887,6 +3071,8 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
     BT_HDR * p_buf;
     UINT16 blocm_x_subband = btif_media_cb.encoder.s16NumOfSubBands *
                              btif_media_cb.encoder.s16NumOfBlocks;
+    tBTIF_AV_MEDIA_FEEDINGS_PCM_STATE *p_pcm = &btif_media_cb.media_feeding_state.pcm;
+    UINT32 nb_pkt = 0;
 
 #if (defined(DEBUG_MEDIA_AV_FLOW) && (DEBUG_MEDIA_AV_FLOW == TRUE))
     APPL_TRACE_DEBUG("btif_media_aa_prep_sbc_2_send nb_frame %d, TxAaQ %d",
@@ -2918,7 +3104,9 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             if (btif_media_aa_read_feeding(UIPC_CH_ID_AV_AUDIO))
             {
                 /* SBC encode and descramble frame */
+                btif_media_sbc_enc_acquire(&(btif_media_cb.encoder));
                 SBC_Encoder(&(btif_media_cb.encoder));
+                btif_media_sbc_enc_release();
                 A2D_SbcChkFrInit(btif_media_cb.encoder.pu8Packet);
                 A2D_SbcDescramble(btif_media_cb.encoder.pu8Packet, btif_media_cb.encoder.u16PacketLength);
                 /* Update SBC frame length */
@@ -2930,6 +3118,7 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             {
                 APPL_TRACE_WARNING("btif_media_aa_prep_sbc_2_send underflow %d, %d",
                     nb_frame, btif_media_cb.media_feeding_state.pcm.aa_feed_residue);
+                p_pcm->underrun_count++;
                 btif_media_cb.media_feeding_state.pcm.counter += nb_frame *
                      btif_media_cb.encoder.s16NumOfSubBands *
                      btif_media_cb.encoder.s16NumOfBlocks *
@@ -2972,6 +3161,7 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
 
             /* Enqueue the encoded SBC frame in AA Tx Queue */
             GKI_enqueue(&(btif_media_cb.TxAaQ), p_buf);
+            nb_pkt++;
         }
         else
         {
@@ -2996,6 +3186,9 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             }
 
             if (btif_media_cb.media_feeding_state.pcm.counter > reset_rate_bytes) {
+                p_pcm->drop_count += p_pcm->counter / (blocm_x_subband *
+                     btif_media_cb.media_feeding.cfg.pcm.num_channel *
+                     btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8);
                 btif_media_cb.media_feeding_state.pcm.counter = 0;
                 APPL_TRACE_WARNING("btif_media_aa_prep_sbc_2_send:reset rate counter");
             }
@@ -3004,6 +3197,9 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             nb_frame = 0;
         }
     }
+
+    /* packets per tick, 4 fractional bits, smoothed like the jitter */
+    p_pcm->pkts_per_tick += ((INT32)(nb_pkt << 4) - (INT32)p_pcm->pkts_per_tick) >> A2DP_TICK_JITTER_SHIFT;
 }
 
 
@@ -3035,6 +3231,58 @@ static void btif_media_aa_prep_2_send(UINT8 nb_frame)
     }
 }
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_adapt_bitpool
+ **
+ ** Description      Lower the SBC bitpool while the link does not keep up with
+ **                  the tx queue and raise it back once the queue stays drained.
+ **                  The frame size follows the bitpool, and so does the number
+ **                  of frames that fit in each packet.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_adapt_bitpool(void)
+{
+    SBC_ENC_PARAMS *pstrEncParams = &btif_media_cb.encoder;
+    SINT16 bitpool = pstrEncParams->s16BitPool;
+
+    if ((btif_media_cb.TxTranscoding != BTIF_MEDIA_TRSCD_PCM_2_SBC) ||
+        (btif_media_cb.max_bitpool <= btif_media_cb.min_bitpool))
+        return;
+
+    if (btif_media_cb.media_feeding_state.pcm.overflow ||
+        (btif_media_cb.TxAaQ.count > btif_media_cb.media_feeding_state.pcm.tx_q_target))
+    {
+        btif_media_cb.bitpool_up_ticks = 0;
+        if (++btif_media_cb.bitpool_down_ticks < BTIF_MEDIA_BITPOOL_DOWN_TICKS)
+            return;
+        btif_media_cb.bitpool_down_ticks = 0;
+        bitpool -= BTIF_MEDIA_BITPOOL_STEP;
+        if (bitpool < btif_media_cb.min_bitpool)
+            bitpool = btif_media_cb.min_bitpool;
+    }
+    else if (btif_media_cb.TxAaQ.count <= 1)
+    {
+        btif_media_cb.bitpool_down_ticks = 0;
+        if (++btif_media_cb.bitpool_up_ticks < BTIF_MEDIA_BITPOOL_UP_TICKS)
+            return;
+        btif_media_cb.bitpool_up_ticks = 0;
+        bitpool += BTIF_MEDIA_BITPOOL_STEP;
+        if (bitpool > btif_media_cb.max_bitpool)
+            bitpool = btif_media_cb.max_bitpool;
+    }
+
+    if (bitpool != pstrEncParams->s16BitPool)
+    {
+        /* the bitpool is read for every frame, no encoder reinit needed */
+        APPL_TRACE_EVENT("btif_media_adapt_bitpool: bitpool %d -> %d, tx queue %d",
+                pstrEncParams->s16BitPool, bitpool, btif_media_cb.TxAaQ.count);
+        pstrEncParams->s16BitPool = bitpool;
+    }
+}
+
 /*******************************************************************************
  **
  ** Function         btif_media_send_aa_frame
@@ -3051,6 +3299,8 @@ static void btif_media_send_aa_frame(void)
     /* get the number of frame to send */
     nb_frame_2_send = btif_get_num_aa_frame();
 
+    btif_media_adapt_bitpool();
+
     if (nb_frame_2_send != 0) {
         /* format and Q buffer to send */
         btif_media_aa_prep_2_send(nb_frame_2_send);
@@ -38,6 +38,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <net/if.h>
 #include <linux/sockios.h>
@@ -149,6 +150,11 @@ static void pan_disable()
             btpan_tap_close(btpan_cb.tap_fd);
             btpan_cb.tap_fd = -1;
         }
+        if(btpan_cb.congest_buf)
+        {
+            GKI_freebuf(btpan_cb.congest_buf);
+            btpan_cb.congest_buf = NULL;
+        }
     }
 }
 
@@ -445,25 +451,25 @@ int btpan_tap_send(int tap_fd, const BD_ADDR src, const BD_ADDR dst, UINT16 prot
     if(tap_fd != -1)
     {
         tETH_HDR eth_hdr;
+        struct iovec iov[2];
         //if(is_empty_eth_addr(dst))
         //    memcpy(&eth_hdr.h_dest, local_addr, ETH_ADDR_LEN);
         //else
         memcpy(&eth_hdr.h_dest, dst, ETH_ADDR_LEN);
         memcpy(&eth_hdr.h_src, src, ETH_ADDR_LEN);
         eth_hdr.h_proto = htons(proto);
-        char packet[2014];
-        memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
         if(len > 2000)
         {
             ALOGE("btpan_tap_send eth packet size:%d is exceeded limit!", len);
             return -1;
         }
-        memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-        /* Send data to network interface */
-        //btnet_send(btpan_cb.conn[i].sock.sock, &buffer, (len + sizeof(tETH_HDR)));
-        //dump_bin("packet to network", packet, len + sizeof(tETH_HDR));
-        int ret = write(tap_fd, packet, len + sizeof(tETH_HDR));
+        /* Send data to network interface, the payload is written from where it is */
+        iov[0].iov_base = &eth_hdr;
+        iov[0].iov_len = sizeof(tETH_HDR);
+        iov[1].iov_base = (void *)buf;
+        iov[1].iov_len = len;
+        int ret = writev(tap_fd, iov, 2);
         BTIF_TRACE_DEBUG("ret:%d", ret);
         return ret;
     }
@@ -704,6 +710,16 @@ static void btu_exec_tap_fd_read(void *p_param) {
     if (fd == -1 || fd != btpan_cb.tap_fd)
         return;
 
+    // Retry the frame BNEP had no room for last time before reading new ones.
+    if (btpan_cb.congest_buf) {
+        BT_HDR *buffer = btpan_cb.congest_buf;
+        btpan_cb.congest_buf = NULL;
+        if (forward_bnep(&btpan_cb.congest_hdr, buffer) == FORWARD_CONGEST) {
+            btpan_cb.congest_buf = buffer;
+            return;
+        }
+    }
+
     // Don't occupy BTU context too long, avoid GKI buffer overruns and
     // give other profiles a chance to run by limiting the amount of memory
     // PAN can use from the shared pool buffer.
@@ -716,31 +732,24 @@ static void btu_exec_tap_fd_read(void *p_param) {
         buffer->offset = PAN_MINIMUM_OFFSET;
         buffer->len = GKI_get_buf_size(buffer) - sizeof(BT_HDR) - buffer->offset;
 
+        // Read the frame straight into the buffer behind the room reserved for
+        // the L2CAP and BNEP headers, so it goes out without another copy.
         UINT8 *packet = (UINT8 *)buffer + sizeof(BT_HDR) + buffer->offset;
-
-        // If we don't have an undelivered packet left over, pull one from the TAP driver.
-        // We save it in the congest_packet right away in case we can't deliver it in this
-        // attempt.
-        if (!btpan_cb.congest_packet_size) {
-            ssize_t ret = read(fd, btpan_cb.congest_packet, sizeof(btpan_cb.congest_packet));
-            switch (ret) {
-                case -1:
-                    BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__, strerror(errno));
-                    GKI_freebuf(buffer);
-                    return;
-                case 0:
-                    BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-                    GKI_freebuf(buffer);
-                    return;
-                default:
-                    btpan_cb.congest_packet_size = ret;
-                    break;
-            }
+        ssize_t ret = read(fd, packet, buffer->len);
+        switch (ret) {
+            case -1:
+                BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__, strerror(errno));
+                GKI_freebuf(buffer);
+                return;
+            case 0:
+                BTIF_TRACE_WARNING("%s end of file reached.", __func__);
+                GKI_freebuf(buffer);
+                return;
+            default:
+                buffer->len = ret;
+                break;
         }
 
-        memcpy(packet, btpan_cb.congest_packet, MIN(btpan_cb.congest_packet_size, buffer->len));
-        buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
         if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR *)packet)) {
             // Extract the ethernet header from the buffer since the PAN_WriteBuf inside
             // forward_bnep can't handle two pointers that point inside the same GKI buffer.
@@ -750,11 +759,15 @@ static void btu_exec_tap_fd_read(void *p_param) {
             // Skip the ethernet header.
             buffer->len -= sizeof(tETH_HDR);
             buffer->offset += sizeof(tETH_HDR);
-            if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-                btpan_cb.congest_packet_size = 0;
+            if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST) {
+                // BNEP handed the buffer back, keep it until the queue drains.
+                // The tx flow on event re-arms the tap fd and gets us back here.
+                btpan_cb.congest_hdr = hdr;
+                btpan_cb.congest_buf = buffer;
+                return;
+            }
         } else {
             BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__, buffer->len);
-            btpan_cb.congest_packet_size = 0;
             GKI_freebuf(buffer);
         }
 
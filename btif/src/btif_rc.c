@@ -26,6 +26,7 @@
  *****************************************************************************/
 #include <hardware/bluetooth.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include "bta_api.h"
 #include "bta_av_api.h"
 #include "avrc_defs.h"
@@ -72,6 +73,17 @@
 #define MAX_CMD_QUEUE_LEN 15
 #define ERR_PLAYER_NOT_ADDRESED 0x13
 
+/* Encoded GetElementAttributes, GetFolderItems and GetItemAttributes responses
+ * kept per connection, so that repeated polls of the same track or folder page
+ * are answered without a round trip to the application */
+#ifndef BTIF_RC_RSP_CACHE_SIZE
+#define BTIF_RC_RSP_CACHE_SIZE     8
+#endif
+/* longest request parameter list used as a cache key */
+#define BTIF_RC_RSP_KEY_MAX        (15 + (4 * BTRC_MAX_ELEM_ATTR_SIZE))
+/* pending requests are kept per channel: control and browse */
+#define BTIF_RC_RSP_CACHE_CHNLS    2
+
 #define CHECK_RC_CONNECTED                                                                  \
     BTIF_TRACE_DEBUG("## %s ##", __FUNCTION__);                                            \
     if(btif_rc_cb.rc_connected == FALSE)                                                    \
@@ -131,6 +143,39 @@ typedef struct
     BOOLEAN is_rsp_pending;
 } btif_rc_cmd_ctxt_t;
 
+typedef struct
+{
+    UINT8   pdu;
+    UINT8   ctype;
+    UINT16  key_len;
+    UINT8   key[BTIF_RC_RSP_KEY_MAX];   /* request parameters */
+    BT_HDR  *p_rsp;                     /* encoded response, before AVRC headers */
+    UINT32  last_used;
+} btif_rc_rsp_cache_entry_t;
+
+/* Request of a cacheable PDU waiting for the application's response */
+typedef struct
+{
+    UINT8   pdu;
+    UINT16  key_len;                    /* 0 if no request is pending */
+    UINT8   key[BTIF_RC_RSP_KEY_MAX];
+} btif_rc_rsp_pend_t;
+
+/* Requests come in on the btif task, responses are stored from the
+ * application's thread; all accesses hold btif_rc_rsp_cache_lock. */
+typedef struct
+{
+    btif_rc_rsp_cache_entry_t entry[BTIF_RC_RSP_CACHE_SIZE];
+    /* pending requests by channel and transaction label */
+    btif_rc_rsp_pend_t pend[BTIF_RC_RSP_CACHE_CHNLS][MAX_LABEL];
+    BOOLEAN track_valid;
+    UINT8   track[8];                   /* track of the cached element attributes */
+    UINT16  uid_counter;                /* uid counter of the cached browse responses */
+    UINT32  use_count;
+    UINT32  hits;
+    UINT32  misses;
+} btif_rc_rsp_cache_t;
+
 /* TODO : Merge btif_rc_reg_notifications_t and btif_rc_cmd_ctxt_t to a single struct */
 typedef struct {
     BOOLEAN                     rc_connected;
@@ -142,6 +187,7 @@ typedef struct {
     btif_rc_reg_notifications_t rc_notif[MAX_RC_NOTIFICATIONS];
     unsigned int                rc_volume;
     uint8_t                     rc_vol_label;
+    btif_rc_rsp_cache_t         rc_rsp_cache;
 } btif_rc_cb_t;
 
 typedef struct {
@@ -240,12 +286,19 @@ static bt_status_t set_addrplayer_rsp(btrc_status_t status_code);
 /*Added for Browsing Message Response */
 static void send_browsemsg_rsp (UINT8 rc_handle, UINT8 label,
     tBTA_AV_CODE code, tAVRC_RESPONSE *pmetamsg_resp);
+static BOOLEAN btif_rc_rsp_cache_send(UINT8 pdu, UINT8 *p_key, UINT16 key_len, UINT8 label);
+static void btif_rc_rsp_cache_store(UINT8 pdu, UINT8 label, UINT8 ctype, BT_HDR *p_msg);
+static void btif_rc_rsp_cache_flush(BOOLEAN browse);
+static void btif_rc_rsp_cache_set_uid_counter(UINT16 uid_counter);
+static void btif_rc_rsp_cache_set_track(UINT8 *p_track, BOOLEAN changed);
+static void btif_rc_rsp_cache_reset(void);
 
 
 /*****************************************************************************
 **  Static variables
 ******************************************************************************/
 static btif_rc_cb_t btif_rc_cb;
+static pthread_mutex_t btif_rc_rsp_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 static btrc_callbacks_t *bt_rc_callbacks = NULL;
 static btrc_ctrl_callbacks_t *bt_rc_ctrl_callbacks = NULL;
 
@@ -515,6 +568,7 @@ void handle_rc_connect (tBTA_AV_RC_OPEN *p_rc_open)
 
         btif_rc_cb.rc_connected = TRUE;
         btif_rc_cb.rc_handle = p_rc_open->rc_handle;
+        btif_rc_rsp_cache_reset();
 
         /* on locally initiated connection we will get remote features as part of connect */
         if (btif_rc_cb.rc_features != 0)
@@ -586,6 +640,7 @@ void handle_rc_disconnect (tBTA_AV_RC_CLOSE *p_rc_close)
     btif_rc_cb.rc_features = 0;
     btif_rc_cb.rc_vol_label=MAX_LABEL;
     btif_rc_cb.rc_volume=MAX_VOLUME;
+    btif_rc_rsp_cache_reset();
     init_all_transactions();
     if (bt_rc_callbacks != NULL)
     {
@@ -753,6 +808,9 @@ void handle_uid_changed_notification(tBTA_AV_META_MSG *pmeta_msg, tAVRC_COMMAND
     avrc_rsp.reg_notif.event_id = pavrc_command->reg_notif.event_id;
     avrc_rsp.reg_notif.param.uid_counter = 0;
 
+    /* the peer is told the uids changed, it will browse again */
+    btif_rc_rsp_cache_flush(TRUE);
+
     send_metamsg_rsp(pmeta_msg->rc_handle, pmeta_msg->label, AVRC_RSP_INTERIM, &avrc_rsp);
     send_metamsg_rsp(pmeta_msg->rc_handle, pmeta_msg->label, AVRC_RSP_CHANGED, &avrc_rsp);
 
@@ -848,6 +906,11 @@ void handle_rc_metamsg_cmd (tBTA_AV_META_MSG *pmeta_msg)
 
         }
 
+        if ((avrc_command.cmd.pdu == AVRC_PDU_GET_ELEMENT_ATTR) &&
+            btif_rc_rsp_cache_send(avrc_command.cmd.pdu, pmeta_msg->p_msg->vendor.p_vendor_data,
+                                   pmeta_msg->p_msg->vendor.vendor_len, pmeta_msg->label))
+            return;
+
         BTIF_TRACE_EVENT("%s: Passing received metamsg command to app. pdu: %s",
             __FUNCTION__, dump_rc_pdu(avrc_command.cmd.pdu));
 
@@ -1016,7 +1079,9 @@ void handle_rc_browsemsg_cmd (tBTA_AV_BROWSE_MSG *pbrowse_msg)
                     dropmsg = handle_get_folder_item_filesystem_cmd(pbrowse_msg, &cmd, &event);
                 break;
             }
-            if (dropmsg == FALSE)
+            if (dropmsg == FALSE &&
+                !btif_rc_rsp_cache_send(event, pbrowse_msg->p_msg->browse.p_browse_data,
+                                        pbrowse_msg->p_msg->browse.browse_len, pbrowse_msg->label))
             {
                 btif_rc_upstreams_evt(event,&cmd,0,pbrowse_msg->label);
             }
@@ -1108,7 +1173,10 @@ void handle_rc_browsemsg_cmd (tBTA_AV_BROWSE_MSG *pbrowse_msg)
                         BTIF_TRACE_ERROR("GetItemAttr attrid: = %d", cmd.get_attrs.attrs[index]);
                     }
                 }
-                btif_rc_upstreams_evt(event, &cmd, 0, pbrowse_msg->label);
+                if (!btif_rc_rsp_cache_send(event, pbrowse_msg->p_msg->browse.p_browse_data,
+                                            pbrowse_msg->p_msg->browse.browse_len,
+                                            pbrowse_msg->label))
+                    btif_rc_upstreams_evt(event, &cmd, 0, pbrowse_msg->label);
                 dropmsg = FALSE;
             }
         }
@@ -1433,6 +1501,12 @@ static void send_metamsg_rsp (UINT8 rc_handle, UINT8 label, tBTA_AV_CODE code,
 
         if (status == AVRC_STS_NO_ERROR)
         {
+            if (pmetamsg_resp->rsp.status == AVRC_STS_NO_ERROR)
+            {
+                if (pmetamsg_resp->rsp.pdu == AVRC_PDU_SET_ADDRESSED_PLAYER)
+                    btif_rc_rsp_cache_flush(TRUE);
+                btif_rc_rsp_cache_store(pmetamsg_resp->rsp.pdu, label, ctype, p_msg);
+            }
             BTA_AvMetaRsp(rc_handle, label, ctype, p_msg);
         }
         else
@@ -1499,6 +1573,16 @@ static void send_browsemsg_rsp (UINT8 rc_handle, UINT8 label, tBTA_AV_CODE code,
     status = AVRC_BldBrowseResponse(rc_handle, pbrowsemsg_resp, &p_msg);
     if (status == AVRC_STS_NO_ERROR)
     {
+        if (pbrowsemsg_resp->rsp.status == AVRC_STS_NO_ERROR)
+        {
+            /* the browsed folder or player changed, or items were renumbered */
+            if ((pbrowsemsg_resp->rsp.pdu == AVRC_PDU_CHANGE_PATH) ||
+                (pbrowsemsg_resp->rsp.pdu == AVRC_PDU_SET_BROWSED_PLAYER))
+                btif_rc_rsp_cache_flush(TRUE);
+            else if (pbrowsemsg_resp->rsp.pdu == AVRC_PDU_GET_FOLDER_ITEMS)
+                btif_rc_rsp_cache_set_uid_counter(pbrowsemsg_resp->get_items.uid_counter);
+            btif_rc_rsp_cache_store(pbrowsemsg_resp->rsp.pdu, label, 0, p_msg);
+        }
         BTA_AvMetaRsp(rc_handle, label, 0, p_msg);
     }
     else
@@ -1524,6 +1608,312 @@ int app_sendbrowsemsg(UINT8 index ,tAVRC_RESPONSE *avrc_rsp)
 }
 
 
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_chnl
+**
+** Description      Map a cacheable PDU to the channel it is received on.
+**
+** Returns          0 for control, 1 for browse, -1 if the PDU is not cached
+**
+*******************************************************************************/
+static int btif_rc_rsp_cache_chnl(UINT8 pdu)
+{
+    switch (pdu)
+    {
+    case AVRC_PDU_GET_ELEMENT_ATTR:
+        return 0;
+    case AVRC_PDU_GET_FOLDER_ITEMS:
+    case AVRC_PDU_GET_ITEM_ATTRIBUTES:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_allowed
+**
+** Description      A response may only be cached while a change of its content
+**                  is reported to us: element attributes need a registered
+**                  track change notification, the player list and the now
+**                  playing list their own change notifications. File system
+**                  items are dropped on path, player and uid counter changes,
+**                  so they are only cached from a database aware player, one
+**                  that reports a uid counter other than 0.
+**
+** Returns          TRUE if the request may be served from and stored in cache
+**
+*******************************************************************************/
+static BOOLEAN btif_rc_rsp_cache_allowed(UINT8 pdu, UINT8 *p_key, UINT16 key_len)
+{
+    UINT8 event_id;
+
+    if (pdu == AVRC_PDU_GET_ELEMENT_ATTR)
+    {
+        event_id = AVRC_EVT_TRACK_CHANGE;
+    }
+    else
+    {
+        /* browse PDUs: pdu, length (2), scope */
+        if (key_len < 4)
+            return FALSE;
+        switch (p_key[3])
+        {
+        case AVRC_SCOPE_FILE_SYSTEM:
+            return (btif_rc_cb.rc_rsp_cache.uid_counter != 0);
+        case AVRC_SCOPE_NOW_PLAYING:
+            event_id = AVRC_EVT_NOW_PLAYING_CHANGE;
+            break;
+        case AVRC_SCOPE_PLAYER_LIST:
+            event_id = AVRC_EVT_AVAL_PLAYERS_CHANGE;
+            break;
+        default:
+            return FALSE;
+        }
+    }
+    return btif_rc_cb.rc_notif[event_id - 1].bNotify;
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_flush_l
+**
+** Description      Drop the cached browse responses (browse == TRUE) or the
+**                  cached element attributes of the current track.
+**                  Called with btif_rc_rsp_cache_lock held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_rc_rsp_cache_flush_l(BOOLEAN browse)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+    btif_rc_rsp_cache_entry_t *p_entry;
+    int i;
+
+    for (i = 0, p_entry = p_cache->entry; i < BTIF_RC_RSP_CACHE_SIZE; i++, p_entry++)
+    {
+        if (p_entry->p_rsp == NULL)
+            continue;
+        if (browse == (p_entry->pdu != AVRC_PDU_GET_ELEMENT_ATTR))
+        {
+            GKI_freebuf(p_entry->p_rsp);
+            p_entry->p_rsp = NULL;
+        }
+    }
+}
+
+static void btif_rc_rsp_cache_flush(BOOLEAN browse)
+{
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    btif_rc_rsp_cache_flush_l(browse);
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_set_uid_counter
+**
+** Description      Drop the cached browse responses if the items were
+**                  renumbered.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_rc_rsp_cache_set_uid_counter(UINT16 uid_counter)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    if (uid_counter != p_cache->uid_counter)
+    {
+        btif_rc_rsp_cache_flush_l(TRUE);
+        p_cache->uid_counter = uid_counter;
+    }
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_set_track
+**
+** Description      Drop the cached element attributes if the track changed.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_rc_rsp_cache_set_track(UINT8 *p_track, BOOLEAN changed)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    if (changed || !p_cache->track_valid ||
+        memcmp(p_cache->track, p_track, sizeof(p_cache->track)))
+    {
+        btif_rc_rsp_cache_flush_l(FALSE);
+        memcpy(p_cache->track, p_track, sizeof(p_cache->track));
+        p_cache->track_valid = TRUE;
+    }
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_reset
+**
+** Description      Drop all cached responses of the connection.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_rc_rsp_cache_reset(void)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    if (p_cache->hits || p_cache->misses)
+        BTIF_TRACE_EVENT("%s: %u hits, %u misses", __FUNCTION__, p_cache->hits, p_cache->misses);
+
+    btif_rc_rsp_cache_flush_l(TRUE);
+    btif_rc_rsp_cache_flush_l(FALSE);
+    memset(p_cache, 0, sizeof(btif_rc_rsp_cache_t));
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_send
+**
+** Description      Answer a request from the cache. On a miss the request
+**                  parameters are remembered under its label so that the
+**                  response built by the application can be stored.
+**
+** Returns          TRUE if the response was sent from the cache
+**
+*******************************************************************************/
+static BOOLEAN btif_rc_rsp_cache_send(UINT8 pdu, UINT8 *p_key, UINT16 key_len, UINT8 label)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+    btif_rc_rsp_cache_entry_t *p_entry;
+    btif_rc_rsp_pend_t *p_pend;
+    BT_HDR *p_msg = NULL;
+    UINT8 ctype = 0;
+    UINT16 size;
+    int i, chnl = btif_rc_rsp_cache_chnl(pdu);
+
+    if (chnl < 0 || label >= MAX_LABEL)
+        return FALSE;
+
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    p_pend = &p_cache->pend[chnl][label];
+    p_pend->key_len = 0;
+
+    if (key_len == 0 || key_len > BTIF_RC_RSP_KEY_MAX ||
+        !btif_rc_rsp_cache_allowed(pdu, p_key, key_len))
+    {
+        pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+        return FALSE;
+    }
+
+    for (i = 0, p_entry = p_cache->entry; i < BTIF_RC_RSP_CACHE_SIZE; i++, p_entry++)
+    {
+        if (p_entry->p_rsp != NULL && p_entry->pdu == pdu && p_entry->key_len == key_len &&
+            memcmp(p_entry->key, p_key, key_len) == 0)
+            break;
+    }
+
+    if (i < BTIF_RC_RSP_CACHE_SIZE)
+    {
+        /* AVRC moves the offset and fragments the message it is given, hand it a copy */
+        size = GKI_get_buf_size(p_entry->p_rsp);
+        if ((p_msg = (BT_HDR *)GKI_getbuf(size)) != NULL)
+        {
+            memcpy(p_msg, p_entry->p_rsp, BT_HDR_SIZE + p_entry->p_rsp->offset + p_entry->p_rsp->len);
+            ctype = p_entry->ctype;
+            p_entry->last_used = ++p_cache->use_count;
+            p_cache->hits++;
+        }
+    }
+
+    if (p_msg == NULL)
+    {
+        p_cache->misses++;
+        p_pend->pdu = pdu;
+        memcpy(p_pend->key, p_key, key_len);
+        p_pend->key_len = key_len;
+    }
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+
+    if (p_msg == NULL)
+        return FALSE;
+
+    BTIF_TRACE_DEBUG("%s: pdu: %s label: %d from cache", __FUNCTION__, dump_rc_pdu(pdu), label);
+    BTA_AvMetaRsp(btif_rc_cb.rc_handle, label, ctype, p_msg);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btif_rc_rsp_cache_store
+**
+** Description      Keep a copy of an encoded response of a cacheable PDU,
+**                  replacing the least recently used entry. The response is
+**                  matched to its request by channel and label.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_rc_rsp_cache_store(UINT8 pdu, UINT8 label, UINT8 ctype, BT_HDR *p_msg)
+{
+    btif_rc_rsp_cache_t *p_cache = &btif_rc_cb.rc_rsp_cache;
+    btif_rc_rsp_cache_entry_t *p_entry, *p_lru = NULL;
+    btif_rc_rsp_pend_t *p_pend;
+    int i, chnl = btif_rc_rsp_cache_chnl(pdu);
+
+    if (chnl < 0 || label >= MAX_LABEL)
+        return;
+
+    pthread_mutex_lock(&btif_rc_rsp_cache_lock);
+    p_pend = &p_cache->pend[chnl][label];
+    if (p_pend->key_len == 0 || p_pend->pdu != pdu)
+    {
+        pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+        return;
+    }
+
+    for (i = 0, p_entry = p_cache->entry; i < BTIF_RC_RSP_CACHE_SIZE; i++, p_entry++)
+    {
+        if (p_entry->p_rsp == NULL)
+        {
+            p_lru = p_entry;
+            break;
+        }
+        if (p_lru == NULL || p_entry->last_used < p_lru->last_used)
+            p_lru = p_entry;
+    }
+
+    if (p_lru->p_rsp != NULL)
+    {
+        GKI_freebuf(p_lru->p_rsp);
+        p_lru->p_rsp = NULL;
+    }
+
+    if ((p_lru->p_rsp = (BT_HDR *)GKI_getbuf(GKI_get_buf_size(p_msg))) != NULL)
+    {
+        memcpy(p_lru->p_rsp, p_msg, BT_HDR_SIZE + p_msg->offset + p_msg->len);
+        p_lru->pdu = pdu;
+        p_lru->ctype = ctype;
+        p_lru->key_len = p_pend->key_len;
+        memcpy(p_lru->key, p_pend->key, p_lru->key_len);
+        p_lru->last_used = ++p_cache->use_count;
+    }
+    p_pend->key_len = 0;
+    pthread_mutex_unlock(&btif_rc_rsp_cache_lock);
+}
+
+
 /*******************************************************************************
 **
 ** Function         btif_rc_upstreams_evt
@@ -2338,6 +2728,9 @@ static bt_status_t register_notification_rsp(btrc_event_id_t event_id,
             break;
         case BTRC_EVT_TRACK_CHANGE:
             memcpy(&(avrc_rsp.reg_notif.param.track), &(p_param->track), sizeof(btrc_uid_t));
+            /* cached element attributes belong to the previous track */
+            btif_rc_rsp_cache_set_track((UINT8 *)&(p_param->track),
+                                        type == BTRC_NOTIFICATION_TYPE_CHANGED);
             break;
         case BTRC_EVT_PLAY_POS_CHANGED:
             avrc_rsp.reg_notif.param.play_pos = p_param->song_pos;
@@ -2352,12 +2745,18 @@ static bt_status_t register_notification_rsp(btrc_event_id_t event_id,
         case BTRC_EVT_ADDRESSED_PLAYER_CHANGED:
             avrc_rsp.reg_notif.param.addr_player.player_id = p_param->player_id;
             avrc_rsp.reg_notif.param.addr_player.uid_counter = 0;
+            if (type == BTRC_NOTIFICATION_TYPE_CHANGED)
+                btif_rc_rsp_cache_flush(TRUE);
             break;
         case BTRC_EVT_AVAILABLE_PLAYERS_CHANGED:
             avrc_rsp.reg_notif.param.evt  = 0x0a;
+            if (type == BTRC_NOTIFICATION_TYPE_CHANGED)
+                btif_rc_rsp_cache_flush(TRUE);
             break;
         case BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED:
             avrc_rsp.reg_notif.param.evt  = 0x09;
+            if (type == BTRC_NOTIFICATION_TYPE_CHANGED)
+                btif_rc_rsp_cache_flush(TRUE);
             break;
         default:
             BTIF_TRACE_WARNING("%s : Unhandled event ID : 0x%x", __FUNCTION__, event_id);
@@ -2885,6 +3284,7 @@ static void cleanup()
     {
         bt_rc_callbacks = NULL;
     }
+    btif_rc_rsp_cache_reset();
     memset(&btif_rc_cb, 0, sizeof(btif_rc_cb_t));
     lbl_destroy();
     BTIF_TRACE_EVENT("## %s ## completed", __FUNCTION__);
@@ -2907,6 +3307,7 @@ static void cleanup_ctrl()
     {
         bt_rc_ctrl_callbacks = NULL;
     }
+    btif_rc_rsp_cache_reset();
     memset(&btif_rc_cb, 0, sizeof(btif_rc_cb_t));
     lbl_destroy();
     BTIF_TRACE_EVENT("## %s ## completed", __FUNCTION__);
@@ -0,0 +1,545 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ **
+ **  Name:          btif_sco_hci.c
+ **
+ **  Description:   SCO/eSCO audio routed over HCI.
+ **
+ **                 RX: received packets are decoded (mSBC, with packet loss
+ **                 concealment) or passed through (CVSD, the controller runs
+ **                 the codec) into a jitter buffer, the rx ring.
+ **
+ **                 TX: one packet is sent per packet received. The controller
+ **                 receives and sends at the same rate, so this paces the
+ **                 microphone data to the air interface without a timer.
+ **
+ **                 Everything runs in BTU task context, the audio HAL is the
+ **                 other side of both rings.
+ **
+ ******************************************************************************/
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "bt_target.h"
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+
+#define LOG_TAG "BTIF-SCO"
+
+#include "gki.h"
+#include "hcidefs.h"
+#include "bta_api.h"
+#include "bta_dm_co.h"
+#include "bta_dm_ci.h"
+#include "btif_sco_hci.h"
+#include "btif_media.h"
+#include "sbc_encoder.h"
+#include "oi_codec_msbc.h"
+
+/*****************************************************************************
+ **  Constants
+ *****************************************************************************/
+
+/* Audio held in the rx ring before the HAL may start reading, restored after
+ * each underrun */
+#ifndef BTIF_SCO_JB_PREFILL_MS
+#define BTIF_SCO_JB_PREFILL_MS      20
+#endif
+
+/* Received audio beyond this is dropped, the HAL is reading too slowly */
+#ifndef BTIF_SCO_JB_MAX_MS
+#define BTIF_SCO_JB_MAX_MS          60
+#endif
+
+/* Microphone audio beyond this is dropped, oldest first */
+#ifndef BTIF_SCO_TX_MAX_MS
+#define BTIF_SCO_TX_MAX_MS          40
+#endif
+
+#define BTIF_SCO_RING_MASK          (BTIF_SCO_RING_SIZE - 1)
+
+#define BTIF_SCO_MSBC_PCM_BYTES     (OI_MSBC_SAMPLES_PER_FRAME * sizeof(SINT16))
+
+/*****************************************************************************
+ **  Local type definitions
+ *****************************************************************************/
+
+typedef struct
+{
+    UINT32  rx_pkts;
+    UINT32  rx_bad;         /* erroneous or lost, concealed */
+    UINT32  rx_drops;       /* bytes dropped on jitter buffer overrun */
+    UINT32  rx_underruns;   /* HAL drained the jitter buffer */
+    UINT32  tx_pkts;
+    UINT32  tx_underruns;   /* packet due but no microphone data */
+    UINT32  tx_drops;       /* bytes dropped, HAL ahead */
+    UINT32  fill_sum;       /* rx + tx buffered bytes, summed per packet */
+} tBTIF_SCO_STATS;
+
+typedef struct
+{
+    tBTIF_SCO_SHM  *p_shm;
+    BOOLEAN         active;
+    BOOLEAN         msbc;
+    UINT16          handle;
+    UINT16          event;
+    UINT16          pkt_size;       /* max TX payload */
+    UINT16          tx_len;         /* TX payload, matches the received size */
+    UINT8           tx_budget;      /* packets due */
+    UINT32          bytes_per_ms;
+
+    /* rx ring head, published to the HAL once the jitter buffer is primed */
+    UINT32          rx_head;
+    BOOLEAN         rx_primed;
+
+    /* mSBC packet reassembly */
+    UINT8           rx_pkt[OI_MSBC_PKT_LEN];
+    UINT16          rx_pkt_len;
+    BOOLEAN         rx_pkt_bad;
+
+    /* encoded mSBC packets, not yet sent */
+    UINT8           tx_pkt[2 * OI_MSBC_PKT_LEN];
+    UINT16          tx_pkt_len;
+
+    tBTIF_SCO_STATS stats;
+} tBTIF_SCO_CB;
+
+/*****************************************************************************
+ **  Static variables
+ *****************************************************************************/
+
+static tBTIF_SCO_CB btif_sco_cb;
+
+/* the SBC encoder state is shared with A2DP, see btif_media_sbc_enc_acquire */
+static SBC_ENC_PARAMS btif_sco_enc;
+static OI_CODEC_SBC_DECODER_CONTEXT btif_sco_dec;
+static OI_UINT32 btif_sco_dec_data[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+static OI_CODEC_MSBC_PLC_STATE btif_sco_plc;
+
+/*****************************************************************************
+ **  Ring helpers
+ *****************************************************************************/
+
+static void btif_sco_ring_write(tBTIF_SCO_RING *p_ring, UINT32 head, const UINT8 *p_data, UINT32 len)
+{
+    UINT32 off = head & BTIF_SCO_RING_MASK;
+    UINT32 first = (len < BTIF_SCO_RING_SIZE - off) ? len : BTIF_SCO_RING_SIZE - off;
+
+    memcpy(&p_ring->data[off], p_data, first);
+    memcpy(p_ring->data, p_data + first, len - first);
+}
+
+static void btif_sco_ring_read(tBTIF_SCO_RING *p_ring, UINT32 tail, UINT8 *p_data, UINT32 len)
+{
+    UINT32 off = tail & BTIF_SCO_RING_MASK;
+    UINT32 first = (len < BTIF_SCO_RING_SIZE - off) ? len : BTIF_SCO_RING_SIZE - off;
+
+    memcpy(p_data, &p_ring->data[off], first);
+    memcpy(p_data + first, p_ring->data, len - first);
+}
+
+/*******************************************************************************
+**
+** Function         btif_sco_rx_write
+**
+** Description      Add decoded audio to the jitter buffer
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_sco_rx_write(const UINT8 *p_data, UINT32 len)
+{
+    tBTIF_SCO_RING *p_ring = &btif_sco_cb.p_shm->rx;
+    UINT32 tail = p_ring->tail;
+    UINT32 prefill = BTIF_SCO_JB_PREFILL_MS * btif_sco_cb.bytes_per_ms;
+
+    /* the HAL caught up with everything published, wait for the prefill again */
+    if (btif_sco_cb.rx_primed && tail == p_ring->head)
+    {
+        btif_sco_cb.rx_primed = FALSE;
+        btif_sco_cb.stats.rx_underruns++;
+    }
+
+    if (btif_sco_cb.rx_head - tail + len > BTIF_SCO_JB_MAX_MS * btif_sco_cb.bytes_per_ms)
+    {
+        btif_sco_cb.stats.rx_drops += len;
+        return;
+    }
+
+    btif_sco_ring_write(p_ring, btif_sco_cb.rx_head, p_data, len);
+    btif_sco_cb.rx_head += len;
+
+    if (!btif_sco_cb.rx_primed && btif_sco_cb.rx_head - tail >= prefill)
+        btif_sco_cb.rx_primed = TRUE;
+
+    if (btif_sco_cb.rx_primed)
+    {
+        /* data before index */
+        __sync_synchronize();
+        p_ring->head = btif_sco_cb.rx_head;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btif_sco_tx_avail
+**
+** Description      Microphone audio available, excess audio is dropped first
+**
+** Returns          bytes available
+**
+*******************************************************************************/
+static UINT32 btif_sco_tx_avail(void)
+{
+    tBTIF_SCO_RING *p_ring = &btif_sco_cb.p_shm->tx;
+    UINT32 max = BTIF_SCO_TX_MAX_MS * btif_sco_cb.bytes_per_ms;
+    UINT32 avail = p_ring->head - p_ring->tail;
+
+    if (avail > BTIF_SCO_RING_SIZE)
+    {
+        /* corrupted indexes, start over */
+        p_ring->tail = p_ring->head;
+        return 0;
+    }
+    if (avail > max)
+    {
+        /* keep sample alignment */
+        UINT32 drop = (avail - max) & ~1;
+
+        p_ring->tail += drop;
+        btif_sco_cb.stats.tx_drops += drop;
+        avail -= drop;
+    }
+    return avail;
+}
+
+static void btif_sco_tx_read(UINT8 *p_data, UINT32 len)
+{
+    tBTIF_SCO_RING *p_ring = &btif_sco_cb.p_shm->tx;
+
+    /* index before data */
+    __sync_synchronize();
+    btif_sco_ring_read(p_ring, p_ring->tail, p_data, len);
+    __sync_synchronize();
+    p_ring->tail += len;
+}
+
+/*****************************************************************************
+ **  mSBC
+ *****************************************************************************/
+
+static BOOLEAN btif_sco_h2_valid(const UINT8 *p)
+{
+    UINT8 sn = p[1] >> 4;
+
+    return p[0] == 0x01 && (p[1] & 0x0f) == 0x08 &&
+           (sn == 0x0 || sn == 0x3 || sn == 0xc || sn == 0xf);
+}
+
+/*******************************************************************************
+**
+** Function         btif_sco_msbc_rx
+**
+** Description      Reassemble mSBC packets from SCO payloads, decode or
+**                  conceal them into the jitter buffer
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_sco_msbc_rx(const UINT8 *p, UINT16 len, BOOLEAN bad)
+{
+    OI_INT16 pcm[OI_MSBC_SAMPLES_PER_FRAME];
+    OI_UINT32 num_bad;
+    UINT16 n, i;
+
+    btif_sco_cb.rx_pkt_bad |= bad;
+
+    while (len)
+    {
+        n = OI_MSBC_PKT_LEN - btif_sco_cb.rx_pkt_len;
+        if (n > len)
+            n = len;
+        memcpy(&btif_sco_cb.rx_pkt[btif_sco_cb.rx_pkt_len], p, n);
+        btif_sco_cb.rx_pkt_len += n;
+        p += n;
+        len -= n;
+
+        if (btif_sco_cb.rx_pkt_len < OI_MSBC_PKT_LEN)
+            break;
+
+        if (!btif_sco_h2_valid(btif_sco_cb.rx_pkt))
+        {
+            /* out of sync, slide to the next H2 header candidate and fill
+               the gap left in the audio */
+            for (i = 1; i < OI_MSBC_PKT_LEN - 1 && !btif_sco_h2_valid(&btif_sco_cb.rx_pkt[i]); i++)
+                ;
+            memmove(btif_sco_cb.rx_pkt, &btif_sco_cb.rx_pkt[i], OI_MSBC_PKT_LEN - i);
+            btif_sco_cb.rx_pkt_len -= i;
+            OI_CODEC_MSBC_PlcBadFrame(&btif_sco_plc, pcm);
+            btif_sco_cb.stats.rx_bad++;
+        }
+        else if (btif_sco_cb.rx_pkt_bad)
+        {
+            OI_CODEC_MSBC_PlcBadFrame(&btif_sco_plc, pcm);
+            btif_sco_cb.stats.rx_bad++;
+            btif_sco_cb.rx_pkt_len = 0;
+        }
+        else
+        {
+            OI_CODEC_MSBC_DecodePackets(&btif_sco_dec, &btif_sco_plc, btif_sco_cb.rx_pkt, 1,
+                                        pcm, &num_bad);
+            btif_sco_cb.stats.rx_bad += num_bad;
+            btif_sco_cb.rx_pkt_len = 0;
+        }
+        btif_sco_cb.rx_pkt_bad = bad;
+
+        btif_sco_rx_write((UINT8 *)pcm, sizeof(pcm));
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btif_sco_msbc_tx_fill
+**
+** Description      Encode microphone audio until a SCO payload is available
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_sco_msbc_tx_fill(void)
+{
+    SINT16 pcm[OI_MSBC_SAMPLES_PER_FRAME];
+
+    while (btif_sco_cb.tx_pkt_len < btif_sco_cb.tx_len &&
+           btif_sco_cb.tx_pkt_len + OI_MSBC_PKT_LEN <= sizeof(btif_sco_cb.tx_pkt) &&
+           btif_sco_tx_avail() >= BTIF_SCO_MSBC_PCM_BYTES)
+    {
+        btif_sco_tx_read((UINT8 *)pcm, BTIF_SCO_MSBC_PCM_BYTES);
+        btif_media_sbc_enc_acquire(&btif_sco_enc);
+        btif_sco_cb.tx_pkt_len += SBC_Encoder_Msbc(&btif_sco_enc, pcm, 1,
+                                                   &btif_sco_cb.tx_pkt[btif_sco_cb.tx_pkt_len]);
+        btif_media_sbc_enc_release();
+    }
+}
+
+/*****************************************************************************
+ **  Externally called functions
+ *****************************************************************************/
+
+BOOLEAN btif_sco_hci_init(UINT32 sample_rate)
+{
+    int fd;
+
+    if (btif_sco_cb.p_shm == NULL)
+    {
+        fd = open(BTIF_SCO_SHM_PATH, O_RDWR | O_CREAT, 0660);
+        if (fd < 0)
+        {
+            BTIF_TRACE_ERROR("%s: cannot open %s: %s", __FUNCTION__, BTIF_SCO_SHM_PATH, strerror(errno));
+            return FALSE;
+        }
+        if (ftruncate(fd, sizeof(tBTIF_SCO_SHM)) == 0)
+        {
+            btif_sco_cb.p_shm = mmap(NULL, sizeof(tBTIF_SCO_SHM), PROT_READ | PROT_WRITE,
+                                     MAP_SHARED, fd, 0);
+            if (btif_sco_cb.p_shm == MAP_FAILED)
+                btif_sco_cb.p_shm = NULL;
+        }
+        close(fd);
+
+        if (btif_sco_cb.p_shm == NULL)
+        {
+            BTIF_TRACE_ERROR("%s: cannot map %s: %s", __FUNCTION__, BTIF_SCO_SHM_PATH, strerror(errno));
+            return FALSE;
+        }
+        btif_sco_cb.p_shm->sample_rate = 0;
+        btif_sco_cb.p_shm->magic = BTIF_SCO_SHM_MAGIC;
+    }
+
+    btif_sco_cb.msbc = (sample_rate == BTA_DM_SCO_SAMP_RATE_16K);
+    btif_sco_cb.bytes_per_ms = sample_rate / 1000 * sizeof(SINT16);
+
+    if (btif_sco_cb.msbc)
+    {
+        btif_media_sbc_enc_acquire(&btif_sco_enc);
+        SBC_Encoder_Init_Msbc(&btif_sco_enc);
+        btif_media_sbc_enc_release();
+        if (!OI_SUCCESS(OI_CODEC_SBC_DecoderReset(&btif_sco_dec, btif_sco_dec_data,
+                                                  sizeof(btif_sco_dec_data), 1, 1, FALSE)) ||
+            !OI_SUCCESS(OI_CODEC_SBC_DecoderConfigureMsbc(&btif_sco_dec)))
+        {
+            BTIF_TRACE_ERROR("%s: mSBC decoder setup failed", __FUNCTION__);
+            return FALSE;
+        }
+        OI_CODEC_MSBC_PlcInit(&btif_sco_plc);
+    }
+
+    BTIF_TRACE_EVENT("%s: %u Hz, %s", __FUNCTION__, sample_rate, btif_sco_cb.msbc ? "mSBC" : "CVSD");
+    return TRUE;
+}
+
+void btif_sco_hci_open(UINT16 handle, UINT8 pkt_size, UINT16 event)
+{
+    tBTIF_SCO_SHM *p_shm = btif_sco_cb.p_shm;
+
+    if (p_shm == NULL)
+        return;
+
+    BTIF_TRACE_EVENT("%s: handle %d, pkt_size %d", __FUNCTION__, handle, pkt_size);
+
+    btif_sco_cb.handle = handle;
+    btif_sco_cb.event = event;
+    btif_sco_cb.pkt_size = pkt_size;
+    btif_sco_cb.tx_len = 0;
+    btif_sco_cb.tx_budget = 0;
+    btif_sco_cb.rx_pkt_len = 0;
+    btif_sco_cb.rx_pkt_bad = FALSE;
+    btif_sco_cb.tx_pkt_len = 0;
+    memset(&btif_sco_cb.stats, 0, sizeof(btif_sco_cb.stats));
+
+    /* the HAL may still hold the old indexes, only move them forward */
+    p_shm->rx.tail = p_shm->rx.head;
+    btif_sco_cb.rx_head = p_shm->rx.head;
+    btif_sco_cb.rx_primed = FALSE;
+    p_shm->tx.tail = p_shm->tx.head;
+
+    __sync_synchronize();
+    p_shm->sample_rate = btif_sco_cb.msbc ? BTA_DM_SCO_SAMP_RATE_16K : BTA_DM_SCO_SAMP_RATE_8K;
+    btif_sco_cb.active = TRUE;
+}
+
+void btif_sco_hci_close(void)
+{
+    tBTIF_SCO_STATS *p_stats = &btif_sco_cb.stats;
+
+    if (!btif_sco_cb.active)
+        return;
+
+    btif_sco_cb.active = FALSE;
+    btif_sco_cb.p_shm->sample_rate = 0;
+
+    BTIF_TRACE_EVENT("%s: rx %u pkts (%u concealed), jitter buffer %u underruns, %u bytes dropped",
+                     __FUNCTION__, p_stats->rx_pkts, p_stats->rx_bad, p_stats->rx_underruns,
+                     p_stats->rx_drops);
+    BTIF_TRACE_EVENT("%s: tx %u pkts, %u underruns, %u bytes dropped, avg buffered %u ms",
+                     __FUNCTION__, p_stats->tx_pkts, p_stats->tx_underruns, p_stats->tx_drops,
+                     p_stats->rx_pkts ? p_stats->fill_sum / p_stats->rx_pkts / btif_sco_cb.bytes_per_ms : 0);
+}
+
+void btif_sco_hci_in_data(BT_HDR *p_buf, tBTM_SCO_DATA_FLAG status)
+{
+    UINT8 *p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+    UINT16 len;
+    tBTIF_SCO_SHM *p_shm = btif_sco_cb.p_shm;
+
+    if (!btif_sco_cb.active || p_buf->len < HCI_SCO_PREAMBLE_SIZE)
+    {
+        GKI_freebuf(p_buf);
+        return;
+    }
+
+    /* skip the handle, the length follows */
+    len = p[2];
+    p += HCI_SCO_PREAMBLE_SIZE;
+    if (len > p_buf->len - HCI_SCO_PREAMBLE_SIZE)
+        len = p_buf->len - HCI_SCO_PREAMBLE_SIZE;
+
+    btif_sco_cb.stats.rx_pkts++;
+    btif_sco_cb.stats.fill_sum += (btif_sco_cb.rx_head - p_shm->rx.tail) +
+                                  (p_shm->tx.head - p_shm->tx.tail);
+
+    if (btif_sco_cb.msbc)
+    {
+        btif_sco_msbc_rx(p, len, status != BTM_SCO_DATA_CORRECT);
+    }
+    else
+    {
+        /* CVSD is decoded by the controller, keep the timing of bad packets with silence */
+        if (status != BTM_SCO_DATA_CORRECT)
+        {
+            memset(p, 0, len);
+            btif_sco_cb.stats.rx_bad++;
+        }
+        btif_sco_rx_write(p, len & ~1);
+    }
+    GKI_freebuf(p_buf);
+
+    /* one packet out for each packet in, sized like the received one */
+    if (len)
+    {
+        btif_sco_cb.tx_len = (len < btif_sco_cb.pkt_size) ? len : btif_sco_cb.pkt_size;
+        if (btif_sco_cb.tx_budget < BTM_SCO_INIT_XMIT_CREDIT)
+            btif_sco_cb.tx_budget++;
+        bta_dm_sco_ci_data_ready(btif_sco_cb.event, btif_sco_cb.handle);
+    }
+}
+
+void btif_sco_hci_out_data(BT_HDR **pp_buf)
+{
+    BT_HDR *p_buf;
+    UINT8 *p;
+    UINT16 len = btif_sco_cb.tx_len;
+
+    *pp_buf = NULL;
+    if (!btif_sco_cb.active || !btif_sco_cb.tx_budget || !len)
+        return;
+
+    if (btif_sco_cb.msbc)
+        btif_sco_msbc_tx_fill();
+
+    if ((btif_sco_cb.msbc && btif_sco_cb.tx_pkt_len < len) ||
+        (!btif_sco_cb.msbc && btif_sco_tx_avail() < len))
+    {
+        /* the packet slot passes, the controller repeats or mutes */
+        btif_sco_cb.tx_budget--;
+        btif_sco_cb.stats.tx_underruns++;
+        return;
+    }
+
+    if ((p_buf = (BT_HDR *)GKI_getpoolbuf(HCI_SCO_POOL_ID)) == NULL)
+        return;
+
+    p_buf->offset = HCI_SCO_PREAMBLE_SIZE;
+    p_buf->len = len;
+    p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+
+    if (btif_sco_cb.msbc)
+    {
+        memcpy(p, btif_sco_cb.tx_pkt, len);
+        btif_sco_cb.tx_pkt_len -= len;
+        memmove(btif_sco_cb.tx_pkt, &btif_sco_cb.tx_pkt[len], btif_sco_cb.tx_pkt_len);
+    }
+    else
+    {
+        btif_sco_tx_read(p, len);
+    }
+
+    btif_sco_cb.tx_budget--;
+    btif_sco_cb.stats.tx_pkts++;
+    *pp_buf = p_buf;
+}
+
+#endif /* BTM_SCO_HCI_INCLUDED == TRUE */
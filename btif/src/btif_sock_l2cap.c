@@ -494,6 +494,8 @@ static void cleanup_l2c_slot(l2c_slot_t* ls)
                                         ls->id, ls->fd, ls->psm, ls->sdp_handle);
     if(ls->fd != -1)
     {
+        if(is_init_done())
+            btsock_thread_remove_fd(pth, ls->fd);
         shutdown(ls->fd, 2);
         close(ls->fd);
         ls->fd = -1;
@@ -639,6 +639,8 @@ static void cleanup_rfc_slot(rfc_slot_t* rs)
     APPL_TRACE_DEBUG("cleanup slot:%d, fd:%d, scn:%d, sdp_handle:0x%x", rs->id, rs->fd, rs->scn, rs->sdp_handle);
     if(rs->fd != -1)
     {
+        if(is_init_done())
+            btsock_thread_remove_fd(pth, rs->fd);
         shutdown(rs->fd, 2);
         close(rs->fd);
         rs->fd = -1;
@@ -972,6 +974,7 @@ static void jv_dm_cback(tBTA_JV_EVT event, tBTA_JV *p_data, void *user_data)
 #define SENT_PARTIAL 1
 #define SENT_NONE 0
 #define SENT_FAILED (-1)
+#define RFC_SOCK_MAX_IOV 16
 static int send_data_to_app(int fd, BT_HDR *p_buf)
 {
     if(p_buf->len == 0)
@@ -998,13 +1001,62 @@ static int send_data_to_app(int fd, BT_HDR *p_buf)
     APPL_TRACE_ERROR("unknown send() error, sent:%d, p_buf->len:%d,  errno:%d", sent, p_buf->len, errno);
     return SENT_FAILED;
 }
+//flush the queued buffers to the app with one sendmsg per batch, instead of
+//one send per buffer
+static int send_queue_to_app(rfc_slot_t* rs)
+{
+    struct iovec iov[RFC_SOCK_MAX_IOV];
+    struct msghdr msg;
+    int count = 0, total = 0;
+    list_node_t *node;
+    for(node = list_begin(rs->incoming_queue);
+        node != list_end(rs->incoming_queue) && count < RFC_SOCK_MAX_IOV; node = list_next(node))
+    {
+        BT_HDR *p_buf = list_node(node);
+        iov[count].iov_base = (UINT8 *)(p_buf + 1) + p_buf->offset;
+        iov[count].iov_len = p_buf->len;
+        total += p_buf->len;
+        count++;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    int sent = sendmsg(rs->fd, &msg, MSG_DONTWAIT);
+    if(sent < 0)
+    {
+        if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            APPL_TRACE_ERROR("send none, EAGAIN or EWOULDBLOCK, errno:%d", errno);
+            return SENT_NONE;
+        }
+        APPL_TRACE_ERROR("unknown sendmsg() error, sent:%d, total:%d, errno:%d", sent, total, errno);
+        return SENT_FAILED;
+    }
+    if(sent < total)
+        APPL_TRACE_ERROR("send partial, sent:%d, total:%d", sent, total);
+    //release what was consumed, trim the buffer that was sent partially
+    int left = sent;
+    while(left > 0)
+    {
+        BT_HDR *p_buf = list_front(rs->incoming_queue);
+        if(left < p_buf->len)
+        {
+            p_buf->offset += left;
+            p_buf->len -= left;
+            break;
+        }
+        left -= p_buf->len;
+        list_remove(rs->incoming_queue, p_buf);
+    }
+    if(sent == total)
+        return SENT_ALL;
+    return sent ? SENT_PARTIAL : SENT_NONE;
+}
 static BOOLEAN flush_incoming_que_on_wr_signal(rfc_slot_t* rs)
 {
     while(!list_is_empty(rs->incoming_queue))
     {
-        BT_HDR *p_buf = list_front(rs->incoming_queue);
-        int sent = send_data_to_app(rs->fd, p_buf);
-        switch(sent)
+        switch(send_queue_to_app(rs))
         {
             case SENT_NONE:
             case SENT_PARTIAL:
@@ -1012,10 +1064,8 @@ static BOOLEAN flush_incoming_que_on_wr_signal(rfc_slot_t* rs)
                 btsock_thread_add_fd(pth, rs->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR, rs->id);
                 return TRUE;
             case SENT_ALL:
-                list_remove(rs->incoming_queue, p_buf);
                 break;
             case SENT_FAILED:
-                list_remove(rs->incoming_queue, p_buf);
                 return FALSE;
         }
     }
@@ -1175,4 +1225,45 @@ int bta_co_rfc_data_outgoing(void *user_data, UINT8* buf, UINT16 size)
     unlock_slot(&slot_lock);
     return ret;
 }
+int bta_co_rfc_data_outgoing_batch(void *user_data, tPORT_DATA_CO_SEG *p_seg, UINT16 num_seg)
+{
+    uint32_t id = (uintptr_t)user_data;
+    int ret = FALSE;
+    struct iovec iov[RFC_SOCK_MAX_IOV];
+    struct msghdr msg;
+    lock_slot(&slot_lock);
+    rfc_slot_t* rs = find_rfc_slot_by_id(id);
+    if(rs)
+    {
+        ret = TRUE;
+        //one read fills up to RFC_SOCK_MAX_IOV rfcomm frames
+        while(num_seg && ret)
+        {
+            int i, count = num_seg < RFC_SOCK_MAX_IOV ? num_seg : RFC_SOCK_MAX_IOV;
+            int size = 0;
+            for(i = 0; i < count; i++)
+            {
+                iov[i].iov_base = p_seg[i].p_data;
+                iov[i].iov_len = p_seg[i].len;
+                size += p_seg[i].len;
+            }
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            int received = recvmsg(rs->fd, &msg, 0);
+            if(received != size)
+            {
+                APPL_TRACE_ERROR("recvmsg error, errno:%d, fd:%d, size:%d, received:%d",
+                                 errno, rs->fd, size, received);
+                cleanup_rfc_slot(rs);
+                ret = FALSE;
+            }
+            p_seg += count;
+            num_seg -= count;
+        }
+    }
+    else APPL_TRACE_ERROR("bta_co_rfc_data_outgoing_batch, invalid slot id:%d", id);
+    unlock_slot(&slot_lock);
+    return ret;
+}
 
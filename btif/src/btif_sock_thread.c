@@ -20,7 +20,7 @@
  *
  *  Filename:      btif_sock_thread.c
  *
- *  Description:   socket select thread
+ *  Description:   socket epoll thread
  *
  *
  ***********************************************************************************/
@@ -44,7 +44,7 @@
 #include <ctype.h>
 
 #include <sys/select.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
 #include <cutils/sockets.h>
 #include <alloca.h>
 
@@ -63,38 +63,38 @@
 #define asrt(s) if(!(s)) APPL_TRACE_ERROR("## %s assert %s failed at line:%d ##",__FUNCTION__, #s, __LINE__)
 #define print_events(events) do { \
     APPL_TRACE_DEBUG("print poll event:%x", events); \
-    if (events & POLLIN) APPL_TRACE_DEBUG(  "   POLLIN "); \
-    if (events & POLLPRI) APPL_TRACE_DEBUG( "   POLLPRI "); \
-    if (events & POLLOUT) APPL_TRACE_DEBUG( "   POLLOUT "); \
-    if (events & POLLERR) APPL_TRACE_DEBUG( "   POLLERR "); \
-    if (events & POLLHUP) APPL_TRACE_DEBUG( "   POLLHUP "); \
-    if (events & POLLNVAL) APPL_TRACE_DEBUG("   POLLNVAL "); \
-    if (events & POLLRDHUP) APPL_TRACE_DEBUG("   POLLRDHUP"); \
+    if (events & EPOLLIN) APPL_TRACE_DEBUG(  "   EPOLLIN "); \
+    if (events & EPOLLPRI) APPL_TRACE_DEBUG( "   EPOLLPRI "); \
+    if (events & EPOLLOUT) APPL_TRACE_DEBUG( "   EPOLLOUT "); \
+    if (events & EPOLLERR) APPL_TRACE_DEBUG( "   EPOLLERR "); \
+    if (events & EPOLLHUP) APPL_TRACE_DEBUG( "   EPOLLHUP "); \
+    if (events & EPOLLRDHUP) APPL_TRACE_DEBUG("   EPOLLRDHUP"); \
     } while(0)
 
 #define MAX_THREAD 8
-#define MAX_POLL 64
-#define POLL_EXCEPTION_EVENTS (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL)
+#define MAX_EPOLL_EVENTS 32     /* events fetched per wake-up, not a limit on fds */
+#define POLL_SLOT_GROW 64
+#define POLL_EXCEPTION_EVENTS (EPOLLHUP | EPOLLRDHUP | EPOLLERR)
 #define IS_EXCEPTION(e) ((e) & POLL_EXCEPTION_EVENTS)
-#define IS_READ(e) ((e) & POLLIN)
-#define IS_WRITE(e) ((e) & POLLOUT)
+#define IS_READ(e) ((e) & EPOLLIN)
+#define IS_WRITE(e) ((e) & EPOLLOUT)
 /*cmd executes in socket poll thread */
 #define CMD_WAKEUP       1
 #define CMD_EXIT         2
-#define CMD_ADD_FD       3
 #define CMD_USER_PRIVATE 4
 
+/* Monitored flags of one fd. A slot is in the epoll set while flags != 0 */
 typedef struct {
-    struct pollfd pfd;
     uint32_t user_id;
     int type;
     int flags;
 } poll_slot_t;
 typedef struct {
     int cmd_fdr, cmd_fdw;
-    int poll_count;
-    poll_slot_t ps[MAX_POLL];
-    int psi[MAX_POLL]; //index of poll slot
+    int epoll_fd;
+    pthread_mutex_t lock; //protects ps and ps_size
+    poll_slot_t* ps; //poll slots indexed by fd
+    int ps_size;
     volatile pid_t thread_id;
     btsock_signaled_cb callback;
     btsock_cmd_cb cmd_callback;
@@ -107,7 +107,8 @@ static thread_slot_t ts[MAX_THREAD];
 static void *sock_poll_thread(void *arg);
 static inline void close_cmd_fd(int h);
 
-static inline void add_poll(int h, int fd, int type, int flags, uint32_t user_id);
+static void add_poll(int h, int fd, int type, int flags, uint32_t user_id);
+static void remove_poll(int h, int fd);
 
 static pthread_mutex_t thread_slot_lock;
 
@@ -196,6 +197,16 @@ static void free_thread_slot(int h)
     if(0 <= h && h < MAX_THREAD)
     {
         close_cmd_fd(h);
+        if(ts[h].epoll_fd != -1)
+        {
+            close(ts[h].epoll_fd);
+            ts[h].epoll_fd = -1;
+        }
+        lock_slot(&ts[h].lock);
+        free(ts[h].ps);
+        ts[h].ps = NULL;
+        ts[h].ps_size = 0;
+        unlock_slot(&ts[h].lock);
         ts[h].used = 0;
     }
     else APPL_TRACE_ERROR("invalid thread handle:%d", h);
@@ -212,9 +223,12 @@ int btsock_thread_init()
         for(h = 0; h < MAX_THREAD; h++)
         {
             ts[h].cmd_fdr = ts[h].cmd_fdw = -1;
+            ts[h].epoll_fd = -1;
             ts[h].used = 0;
             ts[h].thread_id = -1;
-            ts[h].poll_count = 0;
+            ts[h].ps = NULL;
+            ts[h].ps_size = 0;
+            init_slot_lock(&ts[h].lock);
             ts[h].callback = NULL;
             ts[h].cmd_callback = NULL;
         }
@@ -232,6 +246,11 @@ int btsock_thread_create(btsock_signaled_cb callback, btsock_cmd_cb cmd_callback
     if(h >= 0)
     {
         init_poll(h);
+        if(ts[h].epoll_fd == -1 || ts[h].cmd_fdr == -1)
+        {
+            free_thread_slot(h);
+            return -1;
+        }
         if((ts[h].thread_id = create_thread(sock_poll_thread, (void*)(uintptr_t)h)) != -1)
         {
             APPL_TRACE_DEBUG("h:%d, thread id:%d", h, ts[h].thread_id);
@@ -257,8 +276,16 @@ static inline void init_cmd_fd(int h)
         return;
     }
     APPL_TRACE_DEBUG("h:%d, cmd_fdr:%d, cmd_fdw:%d", h, ts[h].cmd_fdr, ts[h].cmd_fdw);
-    //add the cmd fd for read & write
-    add_poll(h, ts[h].cmd_fdr, 0, SOCK_THREAD_FD_RD, 0);
+    //the cmd fd stays armed for read for the lifetime of the thread
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = ts[h].cmd_fdr;
+    if(epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ts[h].cmd_fdr, &ev) < 0)
+    {
+        APPL_TRACE_ERROR("epoll_ctl add cmd fd failed: %s", strerror(errno));
+        close_cmd_fd(h);
+    }
 }
 static inline void close_cmd_fd(int h)
 {
@@ -293,21 +320,25 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id)
         APPL_TRACE_ERROR("cmd socket is not created. socket thread may not initialized");
         return FALSE;
     }
-    if(flags & SOCK_THREAD_ADD_FD_SYNC)
+    //epoll_ctl is safe to call from any thread, so the fd is added right away
+    //instead of going through the cmd socket. The one-time sync flag is moot.
+    flags &= ~SOCK_THREAD_ADD_FD_SYNC;
+    APPL_TRACE_DEBUG("adding fd:%d, flags:0x%x", fd, flags);
+    add_poll(h, fd, type, flags, user_id);
+    return TRUE;
+}
+int btsock_thread_remove_fd(int h, int fd)
+{
+    if(h < 0 || h >= MAX_THREAD)
     {
-        //must executed in socket poll thread
-        if(ts[h].thread_id == pthread_self())
-        {
-            //cleanup one-time flags
-            flags &= ~SOCK_THREAD_ADD_FD_SYNC;
-            add_poll(h, fd, type, flags, user_id);
-            return TRUE;
-        }
-        APPL_TRACE_DEBUG("THREAD_ADD_FD_SYNC is not called in poll thread, fallback to async");
+        APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
+        return FALSE;
     }
-    sock_cmd_t cmd = {CMD_ADD_FD, fd, type, flags, user_id};
-    APPL_TRACE_DEBUG("adding fd:%d, flags:0x%x", fd, flags);
-    return send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0) == sizeof(cmd);
+    //epoll forgets a closed fd silently, take it out before it is closed so
+    //its slot is clean when the number is reused
+    APPL_TRACE_DEBUG("removing fd:%d", fd);
+    remove_poll(h, fd);
+    return TRUE;
 }
 int btsock_thread_post_cmd(int h, int type, const unsigned char* data, int size, uint32_t user_id)
 {
@@ -382,84 +413,119 @@ int btsock_thread_exit(int h)
 }
 static void init_poll(int h)
 {
-    int i;
-    ts[h].poll_count = 0;
     ts[h].thread_id = -1;
     ts[h].callback = NULL;
     ts[h].cmd_callback = NULL;
-    for(i = 0; i < MAX_POLL; i++)
+    ts[h].ps = NULL;
+    ts[h].ps_size = 0;
+    ts[h].epoll_fd = epoll_create(MAX_EPOLL_EVENTS);
+    if(ts[h].epoll_fd == -1)
     {
-        ts[h].ps[i].pfd.fd = -1;
-        ts[h].psi[i] = -1;
+        APPL_TRACE_ERROR("epoll_create failed: %s", strerror(errno));
+        return;
     }
     init_cmd_fd(h);
 }
-static inline unsigned int flags2pevents(int flags)
+static inline uint32_t flags2epevents(int flags)
 {
-    unsigned int pevents = 0;
+    //one-shot: a signaled fd stays disabled until its remaining flags are re-armed
+    uint32_t events = EPOLLONESHOT | EPOLLRDHUP;
     if(flags & SOCK_THREAD_FD_WR)
-        pevents |= POLLOUT;
+        events |= EPOLLOUT;
     if(flags & SOCK_THREAD_FD_RD)
-        pevents |= POLLIN;
-    pevents |= POLL_EXCEPTION_EVENTS;
-    return pevents;
+        events |= EPOLLIN;
+    return events;
 }
-
-static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags, uint32_t user_id)
+//must be called with ts[h].lock held
+static poll_slot_t* get_poll_slot(int h, int fd)
 {
-    ps->pfd.fd = fd;
-    ps->user_id = user_id;
-    if(ps->type != 0 && ps->type != type)
-        APPL_TRACE_ERROR("poll socket type should not changed! type was:%d, type now:%d", ps->type, type);
-    ps->type = type;
-    ps->flags = flags;
-    ps->pfd.events = flags2pevents(flags);
-    ps->pfd.revents = 0;
+    if(fd >= ts[h].ps_size)
+    {
+        int size = (fd / POLL_SLOT_GROW + 1) * POLL_SLOT_GROW;
+        poll_slot_t* ps = (poll_slot_t*)realloc(ts[h].ps, size * sizeof(poll_slot_t));
+        if(!ps)
+        {
+            APPL_TRACE_ERROR("no memory for poll slot of fd:%d", fd);
+            return NULL;
+        }
+        memset(ps + ts[h].ps_size, 0, (size - ts[h].ps_size) * sizeof(poll_slot_t));
+        ts[h].ps = ps;
+        ts[h].ps_size = size;
+    }
+    return &ts[h].ps[fd];
 }
-static inline void add_poll(int h, int fd, int type, int flags, uint32_t user_id)
+//must be called with ts[h].lock held. Arms the fd with the slot flags, or
+//takes it out of the epoll set if no flags are left. req_flags are the flags
+//asked for by the caller, they replace the slot flags if the fd turns out to
+//be a new file reusing the number of a closed one
+static void update_poll(int h, int fd, poll_slot_t* ps, int was_armed, int req_flags)
 {
-    asrt(fd != -1);
-    int i;
-    int empty = -1;
-    poll_slot_t* ps = ts[h].ps;
-
-    for(i = 0; i < MAX_POLL; i++)
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.data.fd = fd;
+    if(ps->flags == 0)
     {
-        if(ps[i].pfd.fd == fd)
+        //clear the slot; EBADF/ENOENT just mean the fd was already closed
+        memset(ps, 0, sizeof(*ps));
+        epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+        return;
+    }
+    ev.events = flags2epevents(ps->flags);
+    int op = was_armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if(epoll_ctl(ts[h].epoll_fd, op, fd, &ev) == 0)
+        return;
+    //the fd may have been closed and reopened behind our back, the flags left
+    //by the closed file must not be armed on the new one
+    if(op == EPOLL_CTL_MOD && errno == ENOENT)
+    {
+        ps->flags = req_flags;
+        if(ps->flags == 0)
         {
-            asrt(ts[h].poll_count < MAX_POLL);
-
-            set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
+            memset(ps, 0, sizeof(*ps));
             return;
         }
-        else if(empty < 0 && ps[i].pfd.fd == -1)
-            empty = i;
+        ev.events = flags2epevents(ps->flags);
+        op = EPOLL_CTL_ADD;
     }
-    if(empty >= 0)
+    else if(op == EPOLL_CTL_ADD && errno == EEXIST)
+        op = EPOLL_CTL_MOD;
+    else op = -1;
+    if(op == -1 || epoll_ctl(ts[h].epoll_fd, op, fd, &ev) < 0)
     {
-        asrt(ts[h].poll_count < MAX_POLL);
-        set_poll(&ps[empty], fd, type, flags, user_id);
-        ++ts[h].poll_count;
-        return;
+        APPL_TRACE_ERROR("epoll_ctl fd:%d, flags:0x%x failed: %s", fd, ps->flags, strerror(errno));
+        memset(ps, 0, sizeof(*ps));
     }
-    APPL_TRACE_ERROR("exceeded max poll slot:%d!", MAX_POLL);
 }
-static inline void remove_poll(int h, poll_slot_t* ps, int flags)
+static void add_poll(int h, int fd, int type, int flags, uint32_t user_id)
 {
-    if(flags == ps->flags)
+    asrt(fd != -1);
+    if(fd < 0)
+        return;
+    lock_slot(&ts[h].lock);
+    poll_slot_t* ps = get_poll_slot(h, fd);
+    if(ps)
     {
-        //all monitored events signaled. To remove it, just clear the slot
-        --ts[h].poll_count;
-        memset(ps, 0, sizeof(*ps));
-        ps->pfd.fd = -1;
+        int was_armed = ps->flags != 0;
+        if(ps->type != 0 && ps->type != type)
+            APPL_TRACE_ERROR("poll socket type should not changed! type was:%d, type now:%d", ps->type, type);
+        ps->type = type;
+        ps->user_id = user_id;
+        ps->flags |= flags;
+        update_poll(h, fd, ps, was_armed, flags);
     }
-    else
+    unlock_slot(&ts[h].lock);
+}
+static void remove_poll(int h, int fd)
+{
+    if(fd < 0)
+        return;
+    lock_slot(&ts[h].lock);
+    if(fd < ts[h].ps_size && ts[h].ps[fd].flags)
     {
-        //one read or one write monitor event signaled, removed the accordding bit
-        ps->flags &= ~flags;
-        //update the poll events mask
-        ps->pfd.events = flags2pevents(ps->flags);
+        ts[h].ps[fd].flags = 0;
+        update_poll(h, fd, &ts[h].ps[fd], TRUE, 0);
     }
+    unlock_slot(&ts[h].lock);
 }
 static int process_cmd_sock(int h)
 {
@@ -473,9 +539,6 @@ static int process_cmd_sock(int h)
     APPL_TRACE_DEBUG("cmd.id:%d", cmd.id);
     switch(cmd.id)
     {
-        case CMD_ADD_FD:
-            add_poll(h, cmd.fd, cmd.type, cmd.flags, cmd.user_id);
-            break;
         case CMD_WAKEUP:
             break;
         case CMD_USER_PRIVATE:
@@ -491,103 +554,71 @@ static int process_cmd_sock(int h)
     }
     return TRUE;
 }
-static void process_data_sock(int h, struct pollfd *pfds, int count)
+static void process_data_sock(int h, int fd, uint32_t events)
 {
-    asrt(count <= ts[h].poll_count);
-    int i;
-    for( i= 1; i < ts[h].poll_count; i++)
+    uint32_t user_id = 0;
+    int type = 0;
+    int flags = 0;
+    print_events(events);
+    lock_slot(&ts[h].lock);
+    poll_slot_t* ps = fd < ts[h].ps_size ? &ts[h].ps[fd] : NULL;
+    //the slot may have been removed since the event was fetched
+    if(ps && ps->flags)
     {
-        if(pfds[i].revents)
-        {
-            int ps_i = ts[h].psi[i];
-            asrt(pfds[i].fd == ts[h].ps[ps_i].pfd.fd);
-            uint32_t user_id = ts[h].ps[ps_i].user_id;
-            int type = ts[h].ps[ps_i].type;
-            int flags = 0;
-            print_events(pfds[i].revents);
-            if(IS_READ(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_RD;
-            }
-            if(IS_WRITE(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_WR;
-            }
-            if(IS_EXCEPTION(pfds[i].revents))
-            {
-                flags |= SOCK_THREAD_FD_EXCEPTION;
-                //remove the whole slot not flags
-                remove_poll(h, &ts[h].ps[ps_i], ts[h].ps[ps_i].flags);
-            }
-            else if(flags)
-                 remove_poll(h, &ts[h].ps[ps_i], flags); //remove the monitor flags that already processed
-            if(flags)
-                ts[h].callback(pfds[i].fd, type, flags, user_id);
-        }
-    }
-}
-
-static void prepare_poll_fds(int h, struct pollfd* pfds)
-{
-    int count = 0;
-    int ps_i = 0;
-    int pfd_i = 0;
-    asrt(ts[h].poll_count <= MAX_POLL);
-    memset(pfds, 0, sizeof(pfds[0])*ts[h].poll_count);
-    while(count < ts[h].poll_count)
-    {
-        if(ps_i >= MAX_POLL)
-        {
-            APPL_TRACE_ERROR("exceed max poll range, ps_i:%d, MAX_POLL:%d, count:%d, ts[h].poll_count:%d",
-                    ps_i, MAX_POLL, count, ts[h].poll_count);
-            return;
-        }
-        if(ts[h].ps[ps_i].pfd.fd >= 0)
+        user_id = ps->user_id;
+        type = ps->type;
+        if(IS_READ(events))
+            flags |= SOCK_THREAD_FD_RD;
+        if(IS_WRITE(events))
+            flags |= SOCK_THREAD_FD_WR;
+        if(IS_EXCEPTION(events))
         {
-            pfds[pfd_i] =  ts[h].ps[ps_i].pfd;
-            ts[h].psi[pfd_i] = ps_i;
-            count++;
-            pfd_i++;
+            flags |= SOCK_THREAD_FD_EXCEPTION;
+            //remove the whole slot not flags
+            ps->flags = 0;
         }
-        ps_i++;
+        else ps->flags &= ~flags; //remove the monitor flags that already processed
+        //re-arm the flags that did not signal, drop them if the fd was closed
+        update_poll(h, fd, ps, TRUE, 0);
     }
+    unlock_slot(&ts[h].lock);
+    if(flags)
+        ts[h].callback(fd, type, flags, user_id);
 }
 static void *sock_poll_thread(void *arg)
 {
-    struct pollfd pfds[MAX_POLL];
-    memset(pfds, 0, sizeof(pfds));
+    struct epoll_event events[MAX_EPOLL_EVENTS];
     int h = (intptr_t)arg;
     for(;;)
     {
-        prepare_poll_fds(h, pfds);
-        int ret = poll(pfds, ts[h].poll_count, -1);
+        int ret = epoll_wait(ts[h].epoll_fd, events, MAX_EPOLL_EVENTS, -1);
         if(ret == -1)
         {
-            APPL_TRACE_ERROR("poll ret -1, exit the thread, errno:%d, err:%s", errno, strerror(errno));
+            if(errno == EINTR)
+                continue;
+            APPL_TRACE_ERROR("epoll_wait ret -1, exit the thread, errno:%d, err:%s", errno, strerror(errno));
             break;
         }
-        if(ret != 0)
+        int i, exit_thread = FALSE;
+        //cmd fd is processed first, as with the poll based loop
+        for(i = 0; i < ret; i++)
         {
-            int need_process_data_fd = TRUE;
-            if(pfds[0].revents) //cmd fd always is the first one
+            if(events[i].data.fd == ts[h].cmd_fdr && !process_cmd_sock(h))
             {
-                asrt(pfds[0].fd == ts[h].cmd_fdr);
-                if(!process_cmd_sock(h))
-                {
-                    APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
-                    break;
-                }
-                if(ret == 1)
-                    need_process_data_fd = FALSE;
-                else ret--; //exclude the cmd fd
+                APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
+                exit_thread = TRUE;
+                break;
             }
-            if(need_process_data_fd)
-                process_data_sock(h, pfds, ret);
         }
-        else {APPL_TRACE_DEBUG("no data, select ret: %d", ret)};
+        if(exit_thread)
+            break;
+        for(i = 0; i < ret; i++)
+        {
+            if(events[i].data.fd != ts[h].cmd_fdr)
+                process_data_sock(h, events[i].data.fd, events[i].events);
+        }
     }
     ts[h].thread_id = -1;
     APPL_TRACE_DEBUG("socket poll thread exiting, h:%d", h);
     return 0;
 }
-
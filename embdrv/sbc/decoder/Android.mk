@@ -13,6 +13,7 @@ LOCAL_SRC_FILES+= \
         ./srce/dequant.c \
         ./srce/framing.c \
         ./srce/framing-sbc.c \
+        ./srce/msbc.c \
         ./srce/oi_codec_version.c \
         ./srce/synthesis-sbc.c \
         ./srce/synthesis-dct8.c \
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef _OI_CODEC_MSBC_H
+#define _OI_CODEC_MSBC_H
+
+/**
+@file
+Decoding of mSBC eSCO packets (HFP wideband speech) with packet loss
+concealment.
+
+@ingroup codec_lib
+*/
+
+#include "oi_codec_sbc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A packet is the 2 byte H2 synchronization header, one mSBC frame and one
+ * padding byte. */
+#define OI_MSBC_H2_HDR_LEN 2
+#define OI_MSBC_PKT_LEN (OI_MSBC_H2_HDR_LEN + OI_MSBC_FRAME_LEN + 1)
+
+/* Packet loss concealment parameters, in samples */
+#define OI_MSBC_PLC_FS      OI_MSBC_SAMPLES_PER_FRAME   /**< Frame size */
+#define OI_MSBC_PLC_N       256                         /**< Pattern search window */
+#define OI_MSBC_PLC_M       64                          /**< Template length */
+#define OI_MSBC_PLC_LHIST   (OI_MSBC_PLC_N + OI_MSBC_PLC_FS - 1)
+#define OI_MSBC_PLC_SBCRT   36                          /**< Decoder reconvergence time */
+#define OI_MSBC_PLC_OLAL    16                          /**< Overlap-add length */
+
+/** Packet loss concealment state, see OI_CODEC_MSBC_PlcInit(). */
+typedef struct {
+    OI_INT16 hist[OI_MSBC_PLC_LHIST + OI_MSBC_PLC_FS + OI_MSBC_PLC_SBCRT + OI_MSBC_PLC_OLAL];
+    OI_UINT bestlag;
+    OI_UINT nbf;            /**< Number of consecutive bad frames */
+} OI_CODEC_MSBC_PLC_STATE;
+
+/**
+ * This function resets the packet loss concealment state. It must be called
+ * at the start of each stream.
+ */
+void OI_CODEC_MSBC_PlcInit(OI_CODEC_MSBC_PLC_STATE *plc);
+
+/**
+ * Synthesizes OI_MSBC_SAMPLES_PER_FRAME samples in place of a frame which was
+ * lost or reported erroneous by the controller.
+ *
+ * @param plc       Packet loss concealment state of the stream.
+ *
+ * @param pcmData   Output, OI_MSBC_SAMPLES_PER_FRAME mono samples.
+ */
+void OI_CODEC_MSBC_PlcBadFrame(OI_CODEC_MSBC_PLC_STATE *plc, OI_INT16 *pcmData);
+
+/**
+ * Decodes a batch of mSBC packets. Packets with a broken H2 header, syncword
+ * or CRC are concealed, so OI_MSBC_SAMPLES_PER_FRAME samples are always
+ * produced per packet.
+ *
+ * @param context       Decoder context, configured with
+ *                      OI_CODEC_SBC_DecoderConfigureMsbc().
+ *
+ * @param plc           Packet loss concealment state of the stream.
+ *
+ * @param packets       numPackets packets of OI_MSBC_PKT_LEN bytes.
+ *
+ * @param numPackets    Number of packets to decode.
+ *
+ * @param pcmData       Output, numPackets * OI_MSBC_SAMPLES_PER_FRAME mono
+ *                      samples.
+ *
+ * @param numBad        Optional output, number of concealed packets.
+ */
+OI_STATUS OI_CODEC_MSBC_DecodePackets(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                      OI_CODEC_MSBC_PLC_STATE *plc,
+                                      const OI_BYTE *packets,
+                                      OI_UINT32 numPackets,
+                                      OI_INT16 *pcmData,
+                                      OI_UINT32 *numBad);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OI_CODEC_MSBC_H */
@@ -65,6 +65,13 @@ Declarations of codec functions, data types, and macros.
 #define SBC_WBS_FRAME_LEN 62
 #define SBC_WBS_SAMPLES_PER_FRAME 128
 
+/* mSBC (HFP wideband speech). The stream configuration is implied by the
+ * syncword: 16 kHz, mono, 15 blocks, 8 subbands, loudness, bitpool 26. */
+#define OI_MSBC_NROF_BLOCKS 15
+#define OI_MSBC_BITPOOL 26
+#define OI_MSBC_FRAME_LEN 57
+#define OI_MSBC_SAMPLES_PER_FRAME 120
+
 
 #define SBC_HEADER_LEN 4
 #define SBC_MAX_FRAME_LEN (SBC_HEADER_LEN + \
@@ -76,6 +83,7 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_SBC_MSBC_SYNCWORD 0xad
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -199,6 +207,7 @@ typedef struct {
     OI_UINT8 restrictSubbands;
     OI_UINT8 enhancedEnabled;
     OI_UINT8 bufferedBlocks;
+    OI_UINT8 msbcEnabled;                   /* Boolean, set by OI_CODEC_SBC_DecoderConfigureMsbc() */
 } OI_CODEC_SBC_DECODER_CONTEXT;
 
 typedef struct {
@@ -260,6 +269,16 @@ OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                     OI_BOOL enhanced,
                                     OI_UINT8 subbands);
 
+/**
+ * This function switches the decoder to mSBC frames. Only frames starting
+ * with the mSBC syncword are decoded until the next call to
+ * OI_CODEC_SBC_DecoderReset(), which must have been called with
+ * maxChannels and pcmStride set to 1.
+ *
+ * @param context   Pointer to the decoder context structure.
+ */
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMsbc(OI_CODEC_SBC_DECODER_CONTEXT *context);
+
 /**
  * This function sets the decoder parameters for a raw decode where the decoder parameters are not
  * available in the sbc data stream. OI_CODEC_SBC_DecoderReset must be called
@@ -113,6 +113,18 @@ OI_STATUS OI_CODEC_SBC_DecodeRaw(OI_CODEC_SBC_DECODER_CONTEXT *context,
                               pcmBytes);
 }
 
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMsbc(OI_CODEC_SBC_DECODER_CONTEXT *context)
+{
+    if (context->common.maxChannels != 1 || context->common.pcmStride != 1) {
+        return OI_STATUS_INVALID_PARAMETERS;
+    }
+
+    context->enhancedEnabled = FALSE;
+    context->common.frameInfo.enhanced = FALSE;
+    context->msbcEnabled = TRUE;
+    return OI_OK;
+}
+
 OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                     OI_BOOL                       enhanced,
                                     OI_UINT8                      subbands)
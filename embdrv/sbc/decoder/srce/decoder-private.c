@@ -91,7 +91,25 @@ INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT *common, const OI_BYTE
     OI_UINT8 d1;
 
 
-    OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD);
+    OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD ||
+              data[0] == OI_SBC_MSBC_SYNCWORD);
+
+    /* mSBC headers carry no configuration, bytes 1 and 2 are reserved. Only
+     * mSBC frames are accepted until the next reset, so cachedInfo is left
+     * alone. */
+    if (data[0] == OI_SBC_MSBC_SYNCWORD) {
+        frame->freqIndex = SBC_FREQ_16000;
+        frame->frequency = 16000;
+        frame->nrof_blocks = OI_MSBC_NROF_BLOCKS;
+        frame->mode = SBC_MONO;
+        frame->nrof_channels = 1;
+        frame->alloc = SBC_LOUDNESS;
+        frame->subbands = SBC_SUBBANDS_8;
+        frame->nrof_subbands = 8;
+        frame->bitpool = OI_MSBC_BITPOOL;
+        frame->crc = data[3];
+        return;
+    }
 
     /* Avoid filling out all these strucutures if we already remember the values
      * from last time. Just in case we get a stream corresponding to data[1] ==
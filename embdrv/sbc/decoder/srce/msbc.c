@@ -0,0 +1,225 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+@file
+mSBC packet decoding and packet loss concealment.
+
+Lost frames are replaced by repeating the part of the history which best
+matches the last OI_MSBC_PLC_M samples (pattern matching), scaled to the
+amplitude of the last frame. The first good frame after a loss is replaced by
+the continued concealment for OI_MSBC_PLC_SBCRT samples while the synthesis
+filter reconverges, then cross-faded over OI_MSBC_PLC_OLAL samples.
+
+@ingroup codec_internal
+*/
+
+#include <string.h>
+
+#include "oi_codec_msbc.h"
+#include "oi_codec_sbc_private.h"
+
+#define PLC_EXT_LEN (OI_MSBC_PLC_FS + OI_MSBC_PLC_SBCRT + OI_MSBC_PLC_OLAL)
+
+/* Bad frames after which the concealment starts to fade out, and the gain
+ * removed per further bad frame */
+#define PLC_ATTEN_START 2
+#define PLC_ATTEN_STEP  0.2f
+
+#define PLC_MAX_SCALE   1.2f
+
+/* Raised cosine, 0.5 * (1 + cos(pi * (i + 1) / (OLAL + 1))) */
+static const float rcos[OI_MSBC_PLC_OLAL] = {
+    0.991487f, 0.966236f, 0.925109f, 0.869504f, 0.801317f, 0.722869f, 0.636831f, 0.546134f,
+    0.453866f, 0.363169f, 0.277131f, 0.198683f, 0.130496f, 0.074891f, 0.033764f, 0.008513f
+};
+
+/* H2 header second octet for sequence numbers 0 to 3 */
+static const OI_BYTE h2_sn[4] = { 0x08, 0x38, 0xc8, 0xf8 };
+
+static OI_INT16 clip16(float v)
+{
+    if (v > 32767.0f) {
+        return 32767;
+    }
+    if (v < -32768.0f) {
+        return -32768;
+    }
+    return (OI_INT16)v;
+}
+
+/**
+ * Returns the index in hist of the OI_MSBC_PLC_M long window which best
+ * correlates with the last OI_MSBC_PLC_M samples of the history.
+ */
+static OI_UINT PatternMatch(const OI_INT16 *hist)
+{
+    const OI_INT16 *tmpl = &hist[OI_MSBC_PLC_LHIST - OI_MSBC_PLC_M];
+    float best = -1.0f;
+    OI_UINT bestn = 0;
+    OI_UINT n, i;
+
+    for (n = 0; n < OI_MSBC_PLC_N; n++) {
+        float corr = 0.0f;
+        float energy = 1.0f;
+        float score;
+
+        for (i = 0; i < OI_MSBC_PLC_M; i++) {
+            corr += (float)tmpl[i] * hist[n + i];
+            energy += (float)hist[n + i] * hist[n + i];
+        }
+        /* normalized, sign preserving correlation without a square root */
+        score = corr * (corr < 0.0f ? -corr : corr) / energy;
+        if (score > best) {
+            best = score;
+            bestn = n;
+        }
+    }
+    return bestn;
+}
+
+/**
+ * Returns the gain which matches the amplitude of the window ending at
+ * bestlag to the one of the template.
+ */
+static float AmplitudeMatch(const OI_INT16 *hist, OI_UINT bestlag)
+{
+    const OI_INT16 *tmpl = &hist[OI_MSBC_PLC_LHIST - OI_MSBC_PLC_M];
+    const OI_INT16 *match = &hist[bestlag - OI_MSBC_PLC_M];
+    float sum_tmpl = 0.0f;
+    float sum_match = 0.0f;
+    float sf;
+    OI_UINT i;
+
+    for (i = 0; i < OI_MSBC_PLC_M; i++) {
+        sum_tmpl += tmpl[i] < 0 ? -tmpl[i] : tmpl[i];
+        sum_match += match[i] < 0 ? -match[i] : match[i];
+    }
+    if (sum_match == 0.0f) {
+        return 1.0f;
+    }
+    sf = sum_tmpl / sum_match;
+    return sf > PLC_MAX_SCALE ? PLC_MAX_SCALE : sf;
+}
+
+static void PlcPushHistory(OI_CODEC_MSBC_PLC_STATE *plc, const OI_INT16 *pcmData)
+{
+    memmove(plc->hist, &plc->hist[OI_MSBC_PLC_FS],
+            (OI_MSBC_PLC_LHIST - OI_MSBC_PLC_FS) * sizeof(OI_INT16));
+    memcpy(&plc->hist[OI_MSBC_PLC_LHIST - OI_MSBC_PLC_FS], pcmData,
+           OI_MSBC_PLC_FS * sizeof(OI_INT16));
+}
+
+void OI_CODEC_MSBC_PlcInit(OI_CODEC_MSBC_PLC_STATE *plc)
+{
+    memset(plc, 0, sizeof(*plc));
+}
+
+void OI_CODEC_MSBC_PlcBadFrame(OI_CODEC_MSBC_PLC_STATE *plc, OI_INT16 *pcmData)
+{
+    OI_INT16 *ext = &plc->hist[OI_MSBC_PLC_LHIST];
+    float gain = 1.0f;
+    OI_UINT i;
+
+    plc->nbf++;
+    if (plc->nbf == 1) {
+        plc->bestlag = PatternMatch(plc->hist) + OI_MSBC_PLC_M;
+        gain = AmplitudeMatch(plc->hist, plc->bestlag);
+    } else if (plc->nbf > PLC_ATTEN_START) {
+        gain = 1.0f - PLC_ATTEN_STEP * (plc->nbf - PLC_ATTEN_START);
+        if (gain < 0.0f) {
+            gain = 0.0f;
+        }
+    }
+
+    /* Extend the history past the frame so the next good frame can be
+     * bridged. Reads may run into samples written by this loop, which
+     * repeats the pattern. */
+    for (i = 0; i < PLC_EXT_LEN; i++) {
+        ext[i] = clip16(gain * plc->hist[plc->bestlag + i]);
+    }
+
+    memcpy(pcmData, ext, OI_MSBC_PLC_FS * sizeof(OI_INT16));
+    PlcPushHistory(plc, pcmData);
+}
+
+static void PlcGoodFrame(OI_CODEC_MSBC_PLC_STATE *plc, OI_INT16 *pcmData)
+{
+    OI_UINT i;
+
+    if (plc->nbf) {
+        /* PlcPushHistory() leaves the extension in place, the samples
+         * following the last concealed frame start at ext[FS] */
+        const OI_INT16 *ext = &plc->hist[OI_MSBC_PLC_LHIST];
+
+        for (i = 0; i < OI_MSBC_PLC_SBCRT; i++) {
+            pcmData[i] = ext[OI_MSBC_PLC_FS + i];
+        }
+        for (i = 0; i < OI_MSBC_PLC_OLAL; i++) {
+            OI_UINT j = OI_MSBC_PLC_SBCRT + i;
+            pcmData[j] = clip16(ext[OI_MSBC_PLC_FS + j] * rcos[i] +
+                                pcmData[j] * rcos[OI_MSBC_PLC_OLAL - 1 - i]);
+        }
+        plc->nbf = 0;
+    }
+    PlcPushHistory(plc, pcmData);
+}
+
+OI_STATUS OI_CODEC_MSBC_DecodePackets(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                      OI_CODEC_MSBC_PLC_STATE *plc,
+                                      const OI_BYTE *packets,
+                                      OI_UINT32 numPackets,
+                                      OI_INT16 *pcmData,
+                                      OI_UINT32 *numBad)
+{
+    OI_UINT32 bad = 0;
+    OI_UINT32 n;
+
+    if (!context->msbcEnabled) {
+        return OI_STATUS_INVALID_PARAMETERS;
+    }
+
+    for (n = 0; n < numPackets; n++) {
+        const OI_BYTE *pkt = &packets[n * OI_MSBC_PKT_LEN];
+        OI_INT16 *pcm = &pcmData[n * OI_MSBC_SAMPLES_PER_FRAME];
+        OI_STATUS status = OI_CODEC_SBC_NO_SYNCWORD;
+
+        if (pkt[0] == 0x01 && (pkt[1] == h2_sn[0] || pkt[1] == h2_sn[1] ||
+                               pkt[1] == h2_sn[2] || pkt[1] == h2_sn[3]) &&
+            pkt[OI_MSBC_H2_HDR_LEN] == OI_SBC_MSBC_SYNCWORD) {
+            const OI_BYTE *frameData = &pkt[OI_MSBC_H2_HDR_LEN];
+            OI_UINT32 frameBytes = OI_MSBC_FRAME_LEN;
+            OI_UINT32 pcmBytes = OI_MSBC_SAMPLES_PER_FRAME * sizeof(OI_INT16);
+
+            status = OI_CODEC_SBC_DecodeFrame(context, &frameData, &frameBytes, pcm, &pcmBytes);
+        }
+
+        if (OI_SUCCESS(status)) {
+            PlcGoodFrame(plc, pcm);
+        } else {
+            TRACE(("mSBC packet %u concealed: %d", n, status));
+            OI_CODEC_MSBC_PlcBadFrame(plc, pcm);
+            bad++;
+        }
+    }
+
+    if (numBad) {
+        *numBad = bad;
+    }
+    return OI_OK;
+}
@@ -67,6 +67,20 @@
 
 #define SBC_NULL    0
 
+/* mSBC (HFP wideband speech): 16 kHz mono, 8 subbands, 15 blocks, loudness,
+ * fixed bitpool 26. Frames are carried in 60 byte eSCO packets made of the
+ * 2 byte H2 synchronization header, the 57 byte frame and one padding byte. */
+#define SBC_MSBC_SYNCWORD       0xAD
+#define SBC_MSBC_BLOCKS         15
+#define SBC_MSBC_BITPOOL        26
+#define SBC_MSBC_FRAME_LEN      57
+#define SBC_MSBC_SAMPLES        (SBC_MSBC_BLOCKS * SUB_BANDS_8)   /* 7.5 ms */
+#define SBC_MSBC_H2_HDR_LEN     2
+#define SBC_MSBC_PKT_LEN        (SBC_MSBC_H2_HDR_LEN + SBC_MSBC_FRAME_LEN + 1)
+#define SBC_MSBC_H2_HDR_0       0x01
+/* H2 header second byte for sequence numbers 0 to 3 */
+#define SBC_MSBC_H2_HDR_1(sn)   ((UINT8)(((sn) & 1 ? 0x30 : 0) | ((sn) & 2 ? 0xC0 : 0) | 0x08))
+
 #ifndef SBC_MAX_NUM_FRAME
 #define SBC_MAX_NUM_FRAME 1
 #endif
@@ -163,6 +177,8 @@ typedef struct SBC_ENC_PARAMS_TAG
                                                        32*numOfSb for stereo & joint stereo */
     UINT16 u16BitRate;
     UINT8   u8NumPacketToEncode;                    /* number of sbc frame to encode. Default is 1 */
+    UINT8   u8Msbc;                                 /* TRUE for mSBC frames, set by SBC_Encoder_Init_Msbc */
+    UINT8   u8H2Seq;                                /* H2 sequence number of the next mSBC packet */
 #if (SBC_JOINT_STE_INCLUDED == TRUE)
     SINT16 as16Join[SBC_MAX_NUM_OF_SUBBANDS];       /*1 if JS, 0 otherwise*/
 #endif
@@ -196,6 +212,10 @@ extern "C"
 #endif
 SBC_API extern void SBC_Encoder(SBC_ENC_PARAMS *strEncParams);
 SBC_API extern void SBC_Encoder_Init(SBC_ENC_PARAMS *strEncParams);
+SBC_API extern void SBC_Encoder_Init_Msbc(SBC_ENC_PARAMS *strEncParams);
+SBC_API extern void SBC_Encoder_Reset(SBC_ENC_PARAMS *strEncParams);
+SBC_API extern UINT16 SBC_Encoder_Msbc(SBC_ENC_PARAMS *strEncParams, const SINT16 *ps16Pcm,
+                                       UINT16 u16NumFrames, UINT8 *pu8Out);
 #ifdef __cplusplus
 }
 #endif
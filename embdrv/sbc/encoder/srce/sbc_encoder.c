@@ -269,6 +269,10 @@ void SBC_Encoder(SBC_ENC_PARAMS *pstrEncParams)
         /* Quantize the encoded audio */
         EncPacking(pstrEncParams);
 
+        /* mSBC frames go to a standard decoder in the peer, never scramble them */
+        if (pstrEncParams->u8Msbc)
+            continue;
+
         /* scramble the code */
         SBC_PRTC_CHK_INIT(pu8);
         SBC_PRTC_CHK_CRC(pu8);
@@ -300,6 +304,7 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
     UINT16 HeaderParams;
 
     pstrEncParams->u8NumPacketToEncode = 1; /* default is one for retrocompatibility purpose */
+    pstrEncParams->u8Msbc = FALSE;
 
     /* Required number of channels */
     if (pstrEncParams->s16ChannelMode == SBC_MONO)
@@ -376,6 +381,23 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
     HeaderParams |= ((pstrEncParams->s16NumOfSubBands >> 3) & 1);  /*4 or 8*/
     pstrEncParams->FrameHeader=HeaderParams;
 
+    APPL_TRACE_EVENT("SBC_Encoder_Init : bitrate %d, bitpool %d",
+            pstrEncParams->u16BitRate, pstrEncParams->s16BitPool);
+
+    SBC_Encoder_Reset(pstrEncParams);
+}
+
+/****************************************************************************
+* SBC_Encoder_Reset - Resets the encoder state kept outside pstrEncParams
+*
+* The analysis filter history and the frame scrambling state are shared by
+* all encoder instances. This sets them up for pstrEncParams again, its
+* configuration and bitpool are kept. Used when two instances take turns.
+*
+* RETURNS : N/A
+*/
+void SBC_Encoder_Reset(SBC_ENC_PARAMS *pstrEncParams)
+{
     if (pstrEncParams->s16NumOfSubBands==4)
     {
         if (pstrEncParams->s16NumOfChannels==1)
@@ -391,11 +413,72 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
             EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-8*10*2)>>4)<<3;
     }
 
-    APPL_TRACE_EVENT("SBC_Encoder_Init : bitrate %d, bitpool %d",
-            pstrEncParams->u16BitRate, pstrEncParams->s16BitPool);
-
     SbcAnalysisInit();
 
     memset(&sbc_prtc_cb, 0, sizeof(tSBC_PRTC_CB));
     sbc_prtc_cb.base = 6 + pstrEncParams->s16NumOfChannels*pstrEncParams->s16NumOfSubBands/2;
 }
+
+/****************************************************************************
+* SBC_Encoder_Init_Msbc - Initializes the encoder for mSBC frames
+*
+* The mSBC configuration is fixed, only the output of the caller (pu8Packet,
+* as16PcmBuffer) is kept from pstrEncParams.
+*
+* RETURNS : N/A
+*/
+void SBC_Encoder_Init_Msbc(SBC_ENC_PARAMS *pstrEncParams)
+{
+    pstrEncParams->s16SamplingFreq = SBC_sf16000;
+    pstrEncParams->s16ChannelMode = SBC_MONO;
+    pstrEncParams->s16NumOfSubBands = SUB_BANDS_8;
+    pstrEncParams->s16NumOfBlocks = SBC_MSBC_BLOCKS;
+    pstrEncParams->s16AllocationMethod = SBC_LOUDNESS;
+    pstrEncParams->u16BitRate = 0;
+
+    SBC_Encoder_Init(pstrEncParams);
+
+    /* the bitpool is fixed, not derived from a bitrate */
+    pstrEncParams->s16BitPool = SBC_MSBC_BITPOOL;
+    pstrEncParams->u8Msbc = TRUE;
+    pstrEncParams->u8H2Seq = 0;
+}
+
+/****************************************************************************
+* SBC_Encoder_Msbc - Encodes u16NumFrames mSBC frames into eSCO packets
+*
+* ps16Pcm holds u16NumFrames * SBC_MSBC_SAMPLES samples. Each frame is
+* written to pu8Out as a SBC_MSBC_PKT_LEN byte packet: the H2 header, the
+* frame and a padding byte. The encoder must have been initialized with
+* SBC_Encoder_Init_Msbc.
+*
+* RETURNS : number of bytes written to pu8Out
+*/
+UINT16 SBC_Encoder_Msbc(SBC_ENC_PARAMS *pstrEncParams, const SINT16 *ps16Pcm,
+                        UINT16 u16NumFrames, UINT8 *pu8Out)
+{
+    UINT8 *pu8Pkt = pu8Out;
+    UINT16 u16Frame;
+
+    for (u16Frame = 0; u16Frame < u16NumFrames; u16Frame++)
+    {
+#if (SBC_NO_PCM_CPY_OPTION == TRUE)
+        pstrEncParams->ps16PcmBuffer = (SINT16 *)ps16Pcm;
+#else
+        memcpy(pstrEncParams->as16PcmBuffer, ps16Pcm, SBC_MSBC_SAMPLES * sizeof(SINT16));
+#endif
+        ps16Pcm += SBC_MSBC_SAMPLES;
+
+        pu8Pkt[0] = SBC_MSBC_H2_HDR_0;
+        pu8Pkt[1] = SBC_MSBC_H2_HDR_1(pstrEncParams->u8H2Seq);
+        pstrEncParams->u8H2Seq = (pstrEncParams->u8H2Seq + 1) & 3;
+
+        pstrEncParams->pu8Packet = pu8Pkt + SBC_MSBC_H2_HDR_LEN;
+        SBC_Encoder(pstrEncParams);
+
+        pu8Pkt[SBC_MSBC_PKT_LEN - 1] = 0;
+        pu8Pkt += SBC_MSBC_PKT_LEN;
+    }
+
+    return (UINT16)(pu8Pkt - pu8Out);
+}
@@ -780,6 +780,67 @@ void *GKI_read_mbox (UINT8 mbox)
     return (p_buf);
 }
 
+/*******************************************************************************
+**
+** Function         GKI_read_mbox_all
+**
+** Description      Called by a task to detach every buffer queued in one of
+**                  its mailboxes with a single lock. The buffers are then
+**                  taken one by one, without locking, with GKI_read_batch().
+**
+** Returns          the batch, or NULL if the mailbox is empty
+**
+*******************************************************************************/
+void *GKI_read_mbox_all (UINT8 mbox)
+{
+    UINT8           task_id = GKI_get_taskid();
+    BUFFER_HDR_T    *p_hdr;
+
+    if ((task_id >= GKI_MAX_TASKS) || (mbox >= NUM_TASK_MBOX))
+        return (NULL);
+
+    GKI_disable();
+
+    p_hdr = gki_cb.com.OSTaskQFirst[task_id][mbox];
+    gki_cb.com.OSTaskQFirst[task_id][mbox] = NULL;
+    gki_cb.com.OSTaskQLast[task_id][mbox]  = NULL;
+
+    GKI_enable();
+
+    return (p_hdr ? (UINT8 *)p_hdr + BUFFER_HDR_SIZE : NULL);
+}
+
+/*******************************************************************************
+**
+** Function         GKI_read_batch
+**
+** Description      Take the next buffer of a batch returned by
+**                  GKI_read_mbox_all(). The batch is owned by the caller, so
+**                  no lock is needed.
+**
+** Parameters:      pp_batch - (input/output) the batch, advanced past the
+**                             returned buffer
+**
+** Returns          the buffer, or NULL when the batch is exhausted
+**
+*******************************************************************************/
+void *GKI_read_batch (void **pp_batch)
+{
+    void            *p_buf = *pp_batch;
+    BUFFER_HDR_T    *p_hdr;
+
+    if (p_buf == NULL)
+        return (NULL);
+
+    p_hdr = (BUFFER_HDR_T *) ((UINT8 *) p_buf - BUFFER_HDR_SIZE);
+    *pp_batch = p_hdr->p_next ? (UINT8 *)p_hdr->p_next + BUFFER_HDR_SIZE : NULL;
+
+    p_hdr->p_next = NULL;
+    p_hdr->status = BUF_STATUS_UNLINKED;
+
+    return (p_buf);
+}
+
 
 
 /*******************************************************************************
@@ -53,12 +53,24 @@
 #define GKI_LINUX_TIMER_TICK_PRIORITY GKI_LINUX_BASE_PRIORITY+2
 #endif
 
+/* Per task wake-up accounting, kept by GKI_send_event() and GKI_wait() */
+typedef struct
+{
+    UINT32  events;             /* events sent to the task, one per message */
+    UINT32  wakeups;            /* signals that woke the task from GKI_wait() */
+    UINT64  wake_lat_us;        /* total signal to wake-up latency */
+    UINT32  wake_lat_max_us;
+} tGKI_WAKE_STATS;
+
 typedef struct
 {
     pthread_mutex_t     GKI_mutex;
     pthread_t           thread_id[GKI_MAX_TASKS];
     pthread_mutex_t     thread_evt_mutex[GKI_MAX_TASKS];
     pthread_cond_t      thread_evt_cond[GKI_MAX_TASKS];
+    BOOLEAN             thread_evt_blocked[GKI_MAX_TASKS];  /* task sleeps on thread_evt_cond */
+    struct timespec     thread_evt_signaled[GKI_MAX_TASKS]; /* when the sleeping task was signaled */
+    tGKI_WAKE_STATS     wake_stats[GKI_MAX_TASKS];
     pthread_mutex_t     thread_timeout_mutex[GKI_MAX_TASKS];
     pthread_cond_t      thread_timeout_cond[GKI_MAX_TASKS];
 #if (GKI_DEBUG == TRUE)
@@ -387,6 +387,8 @@ UINT8 GKI_create_task (TASKPTR task_entry, UINT8 task_id, INT8 *taskname, UINT16
     pthread_cond_init (&gki_cb.os.thread_evt_cond[task_id], &cond_attr);
     pthread_mutex_init(&gki_cb.os.thread_timeout_mutex[task_id], NULL);
     pthread_cond_init (&gki_cb.os.thread_timeout_cond[task_id], NULL);
+    gki_cb.os.thread_evt_blocked[task_id] = FALSE;
+    memset(&gki_cb.os.wake_stats[task_id], 0, sizeof(tGKI_WAKE_STATS));
 
     pthread_attr_init(&attr1);
     /* by default, pthread creates a joinable thread */
@@ -450,6 +452,28 @@ UINT8 GKI_create_task (TASKPTR task_entry, UINT8 task_id, INT8 *taskname, UINT16
     return (GKI_SUCCESS);
 }
 
+/*******************************************************************************
+**
+** Function         gki_print_wake_stats
+**
+** Description      Log how many events the task received, how many context
+**                  switches they took and how long the wake-ups were.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gki_print_wake_stats(UINT8 task_id)
+{
+    tGKI_WAKE_STATS *p_stats = &gki_cb.os.wake_stats[task_id];
+
+    if (p_stats->wakeups == 0)
+        return;
+
+    ALOGI("GKI task [%s]: %u events, %u wakeups, wake latency avg %u us max %u us",
+          gki_cb.com.OSTName[task_id], p_stats->events, p_stats->wakeups,
+          (UINT32)(p_stats->wake_lat_us / p_stats->wakeups), p_stats->wake_lat_max_us);
+}
+
 void GKI_destroy_task(UINT8 task_id)
 {
 #if ( FALSE == GKI_PTHREAD_JOINABLE )
@@ -499,6 +523,7 @@ void GKI_destroy_task(UINT8 task_id)
             ALOGE( "pthread_join() FAILED: result: %d", result );
         }
 #endif
+        gki_print_wake_stats(task_id);
         GKI_exit_task(task_id);
         ALOGI( "GKI_shutdown(): task [%s] terminated\n", gki_cb.com.OSTName[task_id]);
     }
@@ -559,6 +584,7 @@ void GKI_task_self_cleanup(UINT8 task_id)
         gki_cb.com.OSTaskTmr3 [task_id] = 0;
 #endif
 
+        gki_print_wake_stats(task_id);
         GKI_exit_task(task_id);
 
         /* Calling pthread_detach here to mark the thread as detached.
@@ -621,6 +647,7 @@ void GKI_shutdown(void)
                 ALOGE( "pthread_join() FAILED: result: %d", result );
             }
 #endif
+            gki_print_wake_stats(task_id - 1);
             GKI_exit_task(task_id - 1);
         }
     }
@@ -731,6 +758,32 @@ void GKI_stop (void)
 }
 
 
+/*******************************************************************************
+**
+** Function         gki_wake_stats_update
+**
+** Description      Account a wake-up of task_id by GKI_send_event(). Called
+**                  with thread_evt_mutex[task_id] held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gki_wake_stats_update(UINT8 task_id)
+{
+    tGKI_WAKE_STATS *p_stats = &gki_cb.os.wake_stats[task_id];
+    struct timespec now;
+    UINT32 lat_us;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    lat_us = (now.tv_sec - gki_cb.os.thread_evt_signaled[task_id].tv_sec) * USEC_PER_SEC +
+             (now.tv_nsec - gki_cb.os.thread_evt_signaled[task_id].tv_nsec) / NSEC_PER_USEC;
+
+    p_stats->wakeups++;
+    p_stats->wake_lat_us += lat_us;
+    if (lat_us > p_stats->wake_lat_max_us)
+        p_stats->wake_lat_max_us = lat_us;
+}
+
 /*******************************************************************************
 **
 ** Function         GKI_wait
@@ -767,6 +820,8 @@ UINT16 GKI_wait (UINT16 flag, UINT32 timeout)
 
     if (!(gki_cb.com.OSWaitEvt[rtask] & flag))
     {
+        gki_cb.os.thread_evt_blocked[rtask] = TRUE;
+
         if (timeout)
         {
             clock_gettime(CLOCK_MONOTONIC, &abstime);
@@ -790,6 +845,11 @@ UINT16 GKI_wait (UINT16 flag, UINT32 timeout)
             pthread_cond_wait(&gki_cb.os.thread_evt_cond[rtask], &gki_cb.os.thread_evt_mutex[rtask]);
         }
 
+        if (gki_cb.os.thread_evt_blocked[rtask])
+            gki_cb.os.thread_evt_blocked[rtask] = FALSE;    /* timeout, nobody signaled */
+        else
+            gki_wake_stats_update(rtask);
+
         /* TODO: check, this is probably neither not needed depending on phtread_cond_wait() implmentation,
          e.g. it looks like it is implemented as a counter in which case multiple cond_signal
          should NOT be lost! */
@@ -904,8 +964,17 @@ UINT8 GKI_send_event (UINT8 task_id, UINT16 event)
 
         /* Set the event bit */
         gki_cb.com.OSWaitEvt[task_id] |= event;
+        gki_cb.os.wake_stats[task_id].events++;
 
-        pthread_cond_signal(&gki_cb.os.thread_evt_cond[task_id]);
+        /* A task that is not sleeping picks the bit up on its next GKI_wait(),
+           and one that was already signaled is on its way; in both cases the
+           signal would only cost a futex call */
+        if (gki_cb.os.thread_evt_blocked[task_id])
+        {
+            gki_cb.os.thread_evt_blocked[task_id] = FALSE;
+            clock_gettime(CLOCK_MONOTONIC, &gki_cb.os.thread_evt_signaled[task_id]);
+            pthread_cond_signal(&gki_cb.os.thread_evt_cond[task_id]);
+        }
 
         pthread_mutex_unlock(&gki_cb.os.thread_evt_mutex[task_id]);
 
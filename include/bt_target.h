@@ -44,6 +44,24 @@
 #define BTIF_HF_CLIENT_SERVICE_NAME  ("Handsfree")
 #endif
 
+/* LE scan reports with the same address and payload as one passed up less than
+** BTIF_GATT_SCAN_MIN_INTERVAL ms before are dropped, unless the RSSI moved by
+** BTIF_GATT_SCAN_RSSI_DELTA dB or more. An interval of 0 passes up every report,
+** an RSSI delta of 0 ignores the RSSI. Both can be set in ble_stack.conf.
+*/
+#ifndef BTIF_GATT_SCAN_MIN_INTERVAL
+#define BTIF_GATT_SCAN_MIN_INTERVAL  100
+#endif
+
+#ifndef BTIF_GATT_SCAN_RSSI_DELTA
+#define BTIF_GATT_SCAN_RSSI_DELTA  6
+#endif
+
+/* Max LE scan reports delivered per btif task wake-up */
+#ifndef BTIF_GATT_SCAN_BATCH_MAX
+#define BTIF_GATT_SCAN_BATCH_MAX  16
+#endif
+
 #ifdef BUILDCFG
 
 #if !defined(HAS_BDROID_BUILDCFG) && !defined(HAS_NO_BDROID_BUILDCFG)
@@ -825,19 +843,33 @@ and USER_HW_DISABLE_API macros */
 /**************************
 ** Initial SCO TX credit
 *************************/
+/* SCO packets handed to the controller before the first packet is received.
+** Afterwards each received packet returns one credit, which paces the host to
+** the air interface. Also bounded by the controller's SCO buffer count. */
+#ifndef BTM_SCO_INIT_XMIT_CREDIT
+#define BTM_SCO_INIT_XMIT_CREDIT    2
+#endif
+
 /* max TX SCO data packet size */
 #ifndef BTM_SCO_DATA_SIZE_MAX
 #define BTM_SCO_DATA_SIZE_MAX       240
 #endif
 
-/* maximum BTM buffering capacity */
+/* maximum BTM buffering capacity in packets, older packets are dropped to bound latency */
 #ifndef BTM_SCO_MAX_BUF_CAP
 #define BTM_SCO_MAX_BUF_CAP     (BTM_SCO_INIT_XMIT_CREDIT * 4)
 #endif
 
-/* The size in bytes of the BTM inquiry database. */
+/* The number of entries in the BTM inquiry database, at most 0xFFFE. The least
+** recently seen device is replaced when it is full. An entry is about 300
+** bytes, platforms that scan crowded areas may raise it in bdroid_buildcfg.h. */
 #ifndef BTM_INQ_DB_SIZE
-#define BTM_INQ_DB_SIZE             40
+#define BTM_INQ_DB_SIZE             256
+#endif
+
+/* The number of hash buckets indexing the BTM inquiry database, a power of 2. */
+#ifndef BTM_INQ_DB_HASH_SIZE
+#define BTM_INQ_DB_HASH_SIZE        128
 #endif
 
 /* This is set to enable automatic periodic inquiry at startup. */
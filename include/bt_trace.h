@@ -199,6 +199,9 @@ EXPORT_API extern void BTE_InitTraceLevels( void );
 /* Prototype for message logging function. */
 EXPORT_API extern void LogMsg (UINT32 trace_set_mask, const char *fmt_str, ...);
 
+/* Writes out the traces kept in memory in trace recorder mode. */
+EXPORT_API extern void bte_log_dump (void);
+
 /* Prototype for stack tracing function. */
 EXPORT_API extern void BTTRC_StackTrace0(tBTTRC_LAYER_ID layer_id,
                                    tBTTRC_TYPE type,
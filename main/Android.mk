@@ -46,6 +46,7 @@ LOCAL_SRC_FILES += \
 	../btif/src/bluetoothTrack.cpp \
 	../btif/src/btif_rc.c \
 	../btif/src/btif_sm.c \
+	../btif/src/btif_sco_hci.c \
 	../btif/src/btif_sock.c \
 	../btif/src/btif_sock_rfc.c \
 	../btif/src/btif_sock_sdp.c \
@@ -32,6 +32,7 @@ extern BOOLEAN hci_logging_enabled;
 extern BOOLEAN hci_save_log;
 extern BOOLEAN trace_conf_enabled;
 void bte_trace_conf_config(const config_t *config);
+void bte_log_start(BOOLEAN recorder);
 
 // Reads the stack configuration file and populates global variables with
 // the contents of the file.
@@ -52,11 +53,17 @@ void bte_load_conf(const char *path) {
   trace_conf_enabled = config_get_bool(config, CONFIG_DEFAULT_SECTION, "TraceConf", false);
 
   bte_trace_conf_config(config);
+
+  if (config_get_bool(config, CONFIG_DEFAULT_SECTION, "TraceAsync", true))
+    bte_log_start(config_get_bool(config, CONFIG_DEFAULT_SECTION, "TraceRecorder", false));
+
   config_free(config);
 }
 
 #if (defined(BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
 extern int btm_ble_tx_power[BTM_BLE_ADV_TX_POWER_MAX + 1];
+extern int btif_gattc_scan_min_interval;
+extern int btif_gattc_scan_rssi_delta;
 void bte_load_ble_conf(const char* path)
 {
   assert(path != NULL);
@@ -76,6 +83,13 @@ void bte_load_ble_conf(const char* path)
     ALOGI("loaded btm_ble_tx_power: %d, %d, %d, %d, %d", (char)btm_ble_tx_power[0], (char)btm_ble_tx_power[1],
                                         btm_ble_tx_power[2], btm_ble_tx_power[3], btm_ble_tx_power[4]);
   }
+
+  btif_gattc_scan_min_interval = config_get_int(config, CONFIG_DEFAULT_SECTION,
+                                                "BLE_SCAN_REPORT_MIN_INTERVAL", btif_gattc_scan_min_interval);
+  btif_gattc_scan_rssi_delta = config_get_int(config, CONFIG_DEFAULT_SECTION,
+                                              "BLE_SCAN_REPORT_RSSI_DELTA", btif_gattc_scan_rssi_delta);
+  ALOGI("scan report filter: min interval %d ms, rssi delta %d", btif_gattc_scan_min_interval,
+        btif_gattc_scan_rssi_delta);
   config_free(config);
 }
 #endif
@@ -34,6 +34,7 @@
 #include "bte.h"
 
 #include "bte_appl.h"
+#include "bt_utils.h"
 
 #if MMI_INCLUDED == TRUE
 #include "mmi.h"
@@ -114,6 +115,10 @@
 
 #include <sys/time.h>
 #include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "semaphore.h"
 
 #if (defined(ANDROID_USE_LOGCAT) && (ANDROID_USE_LOGCAT==TRUE))
 const char * const bt_layer_tags[] = {
@@ -222,32 +227,43 @@ const char * const bt_layer_tags[] = {
 #endif
 #define DBG_TRACE_DEBUG2( m, p0, p1 ) BT_TRACE( TRACE_LAYER_BTM, (TRACE_ORG_APPL|TRACE_TYPE_DEBUG), m, p0, p1 )
 
-void
-LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+/* Traces are formatted by the calling thread into a lock-free ring and written
+ * out by bte_log_thread, so a logcat write never stalls btu or the media task.
+ * In recorder mode only warnings and errors are written out, and the last
+ * BTE_LOG_RING_SIZE traces stay in memory until bte_log_dump() is called on a
+ * controller hardware error or HCI command timeout. */
+#ifndef BTE_LOG_RING_SIZE
+#define BTE_LOG_RING_SIZE  128      /* must be a power of 2 */
+#endif
+
+typedef struct
+{
+    volatile UINT32 seq;            /* ticket + 1 once the record is complete */
+    UINT32          trace_set_mask;
+    UINT64          timestamp_ns;
+    char            buffer[BTE_LOG_BUF_SIZE];
+} tBTE_LOG_REC;
+
+static struct
+{
+    tBTE_LOG_REC    rec[BTE_LOG_RING_SIZE];
+    volatile UINT32 head;           /* next ticket to claim */
+    volatile UINT32 tail;           /* next ticket to write out */
+    volatile UINT32 dropped;        /* traces lost to a full ring */
+    volatile UINT32 wake_pending;
+    volatile BOOLEAN running;
+    BOOLEAN         recorder;
+    semaphore_t     *wake;          /* kept for the process lifetime */
+    pthread_t       thread;
+    pthread_mutex_t dump_lock;
+} bte_log;
+
+static void bte_log_emit(UINT32 trace_set_mask, const char *buffer)
 {
-	static char buffer[BTE_LOG_BUF_SIZE];
     int trace_layer = TRACE_GET_LAYER(trace_set_mask);
     if (trace_layer >= TRACE_LAYER_MAX_NUM)
         trace_layer = 0;
 
-	va_list ap;
-#if (BTE_ANDROID_INTERNAL_TIMESTAMP==TRUE)
-	struct timeval tv;
-	struct timezone tz;
-	struct tm *tm;
-	time_t t;
-
-	gettimeofday(&tv, &tz);
-	time(&t);
-	tm = localtime(&t);
-
-    sprintf(buffer, "%02d:%02d:%02d.%03d ", tm->tm_hour, tm->tm_min, tm->tm_sec,
-        tv.tv_usec / 1000);
-#endif
-	va_start(ap, fmt_str);
-	vsnprintf(&buffer[MSG_BUFFER_OFFSET], BTE_LOG_MAX_SIZE, fmt_str, ap);
-	va_end(ap);
-
 #if (defined(ANDROID_USE_LOGCAT) && (ANDROID_USE_LOGCAT==TRUE))
 #if (BTE_MAP_TRACE_LEVEL==TRUE)
     switch ( TRACE_GET_TYPE(trace_set_mask) )
@@ -273,11 +289,229 @@ LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
     LOGI0(bt_layer_tags[trace_layer], buffer);
 #endif
 #else
+    UNUSED(trace_layer);
 	write(2, buffer, strlen(buffer));
 	write(2, "\n", 1);
 #endif
 }
 
+static int bte_log_format(char *buffer, const char *fmt_str, va_list ap)
+{
+#if (BTE_ANDROID_INTERNAL_TIMESTAMP==TRUE)
+	struct timeval tv;
+	struct timezone tz;
+	struct tm *tm;
+	time_t t;
+
+	gettimeofday(&tv, &tz);
+	time(&t);
+	tm = localtime(&t);
+
+    sprintf(buffer, "%02d:%02d:%02d.%03d ", tm->tm_hour, tm->tm_min, tm->tm_sec,
+        tv.tv_usec / 1000);
+#endif
+	return vsnprintf(&buffer[MSG_BUFFER_OFFSET], BTE_LOG_MAX_SIZE, fmt_str, ap);
+}
+
+/* Returns FALSE if the ring is full and the trace was dropped */
+static BOOLEAN bte_log_put(UINT32 trace_set_mask, const char *fmt_str, va_list ap)
+{
+    tBTE_LOG_REC *p_rec;
+    struct timespec ts;
+    UINT32 ticket;
+
+    do
+    {
+        ticket = bte_log.head;
+        if (ticket - bte_log.tail >= BTE_LOG_RING_SIZE)
+        {
+            __sync_fetch_and_add(&bte_log.dropped, 1);
+            return FALSE;
+        }
+    } while (!__sync_bool_compare_and_swap(&bte_log.head, ticket, ticket + 1));
+
+    p_rec = &bte_log.rec[ticket & (BTE_LOG_RING_SIZE - 1)];
+    p_rec->seq = 0;
+    __sync_synchronize();
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    p_rec->timestamp_ns = (UINT64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    p_rec->trace_set_mask = trace_set_mask;
+    bte_log_format(p_rec->buffer, fmt_str, ap);
+
+    __sync_synchronize();
+    p_rec->seq = ticket + 1;
+
+    /* one wake-up per burst, the thread clears the flag before draining */
+    if (__sync_lock_test_and_set(&bte_log.wake_pending, 1) == 0)
+        semaphore_post(bte_log.wake);
+    return TRUE;
+}
+
+static void bte_log_drain(void)
+{
+    static char buffer[64];
+    tBTE_LOG_REC *p_rec;
+    UINT32 dropped;
+    UINT32 type;
+
+    for (;;)
+    {
+        p_rec = &bte_log.rec[bte_log.tail & (BTE_LOG_RING_SIZE - 1)];
+        if (p_rec->seq != bte_log.tail + 1)
+            break;
+        __sync_synchronize();
+
+        if ((dropped = __sync_lock_test_and_set(&bte_log.dropped, 0)) != 0)
+        {
+            snprintf(buffer, sizeof(buffer), "%u trace messages dropped", dropped);
+            bte_log_emit(TRACE_TYPE_WARNING, buffer);
+        }
+
+        type = TRACE_GET_TYPE(p_rec->trace_set_mask);
+        if (!bte_log.recorder || (type == TRACE_TYPE_ERROR) || (type == TRACE_TYPE_WARNING))
+            bte_log_emit(p_rec->trace_set_mask, p_rec->buffer);
+
+        __sync_synchronize();
+        bte_log.tail++;
+    }
+}
+
+static void *bte_log_thread(void *arg)
+{
+    UNUSED(arg);
+
+    while (bte_log.running)
+    {
+        semaphore_wait(bte_log.wake);
+        __sync_lock_release(&bte_log.wake_pending);
+        __sync_synchronize();
+        bte_log_drain();
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         bte_log_start
+**
+** Description      Start writing traces from a background thread. In recorder
+**                  mode only warnings and errors are written out.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bte_log_start(BOOLEAN recorder)
+{
+    if (bte_log.running)
+        return;
+
+    /* a producer may still post the semaphore after bte_log_stop, so it is
+     * created once and never freed */
+    if (bte_log.wake == NULL)
+    {
+        if ((bte_log.wake = semaphore_new(0)) == NULL)
+            return;
+        pthread_mutex_init(&bte_log.dump_lock, NULL);
+    }
+
+    bte_log.recorder = recorder;
+    bte_log.running = TRUE;
+    if (pthread_create(&bte_log.thread, NULL, bte_log_thread, NULL) != 0)
+        bte_log.running = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         bte_log_stop
+**
+** Description      Write out the pending traces and stop the trace thread.
+**                  Traces are written synchronously afterwards. A trace still
+**                  being published by another thread is written out by the
+**                  next bte_log_start.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bte_log_stop(void)
+{
+    if (!bte_log.running)
+        return;
+
+    bte_log.running = FALSE;
+    semaphore_post(bte_log.wake);
+    pthread_join(bte_log.thread, NULL);
+
+    /* write out what was published after the thread's last drain */
+    bte_log_drain();
+}
+
+/*******************************************************************************
+**
+** Function         bte_log_dump
+**
+** Description      Write out the traces held in the ring, oldest first, with
+**                  their capture time. Does nothing outside recorder mode.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bte_log_dump(void)
+{
+    static char buffer[BTE_LOG_BUF_SIZE + 32];
+    tBTE_LOG_REC *p_rec;
+    UINT32 head, ticket, seq;
+    int len;
+
+    /* outside recorder mode every trace was already written out */
+    if (!bte_log.running || !bte_log.recorder)
+        return;
+
+    pthread_mutex_lock(&bte_log.dump_lock);
+
+    head = bte_log.head;
+    for (ticket = head - BTE_LOG_RING_SIZE; ticket != head; ticket++)
+    {
+        p_rec = &bte_log.rec[ticket & (BTE_LOG_RING_SIZE - 1)];
+        if ((seq = p_rec->seq) != ticket + 1)
+            continue;
+        __sync_synchronize();
+
+        len = snprintf(buffer, sizeof(buffer), "[%llu.%06llu] ",
+                (unsigned long long)(p_rec->timestamp_ns / 1000000000),
+                (unsigned long long)(p_rec->timestamp_ns % 1000000000) / 1000);
+        strlcpy(&buffer[len], p_rec->buffer, sizeof(buffer) - len);
+
+        /* skip a record overwritten while it was copied */
+        __sync_synchronize();
+        if (p_rec->seq == seq)
+            bte_log_emit(p_rec->trace_set_mask, buffer);
+    }
+
+    pthread_mutex_unlock(&bte_log.dump_lock);
+}
+
+void
+LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+	static char buffer[BTE_LOG_BUF_SIZE];
+	va_list ap;
+
+	va_start(ap, fmt_str);
+    if (bte_log.running)
+    {
+        bte_log_put(trace_set_mask, fmt_str, ap);
+        va_end(ap);
+        return;
+    }
+
+    /* no trace thread yet, write it out from here */
+	bte_log_format(buffer, fmt_str, ap);
+	va_end(ap);
+
+    bte_log_emit(trace_set_mask, buffer);
+}
+
 void
 ScrLog(UINT32 trace_set_mask, const char *fmt_str, ...)
 {
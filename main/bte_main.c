@@ -115,6 +115,7 @@ BT_API void BTE_UnloadStack(void);
 extern void scru_flip_bda (BD_ADDR dst, const BD_ADDR src);
 extern void bte_load_conf(const char *p_path);
 extern void bte_load_ble_conf(const char *p_path);
+extern void bte_log_stop(void);
 extern bt_bdaddr_t btif_local_bd_addr;
 
 
@@ -193,6 +194,8 @@ void bte_main_shutdown()
     pthread_mutex_destroy(&cleanup_lock);
 
     GKI_shutdown();
+
+    bte_log_stop();
 }
 
 /******************************************************************************
@@ -999,7 +999,19 @@ UINT16 AVDT_WriteReqOpt(UINT8 handle, BT_HDR *p_pkt, UINT32 time_stamp, UINT8 m_
 #if AVDT_MULTIPLEXING == TRUE
         GKI_init_q (&evt.apiwrite.frag_q);
 #endif
-        avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
+        if (p_scb->state == AVDT_SCB_STREAM_ST)
+        {
+            /* Media packets are only accepted while streaming, and this is the
+            ** hot path. Run the actions of the STREAM state table entry for
+            ** AVDT_SCB_API_WRITE_REQ_EVT directly; the state does not change. */
+            p_scb->curr_evt = AVDT_SCB_API_WRITE_REQ_EVT;
+            avdt_scb_hdl_write_req(p_scb, &evt);
+            avdt_scb_chk_snd_pkt(p_scb, &evt);
+        }
+        else
+        {
+            avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
+        }
     }
 
     return result;
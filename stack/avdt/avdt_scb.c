@@ -393,6 +393,7 @@ const UINT8 avdt_scb_st_open[][AVDT_SCB_NUM_COLS] = {
 };
 
 /* state table for streaming state */
+/* Note: AVDT_WriteReqOpt runs the API_WRITE_REQ_EVT actions directly in this state */
 const UINT8 avdt_scb_st_stream[][AVDT_SCB_NUM_COLS] = {
 /* Event                     Action 1                       Action 2                    Next state */
 /* API_REMOVE_EVT */        {AVDT_SCB_SND_STREAM_CLOSE,     AVDT_SCB_SET_REMOVE,        AVDT_SCB_CLOSING_ST},
@@ -354,7 +354,8 @@ tBNEP_RESULT BNEP_Disconnect (UINT16 handle)
 ** Returns:         BNEP_WRONG_HANDLE       - if passed handle is not valid
 **                  BNEP_MTU_EXCEDED        - If the data length is greater than MTU
 **                  BNEP_IGNORE_CMD         - If the packet is filtered out
-**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full. The buffer is
+**                                            not released in this case
 **                  BNEP_SUCCESS            - If written successfully
 **
 *******************************************************************************/
@@ -431,12 +432,9 @@ tBNEP_RESULT BNEP_WriteBuf (UINT16 handle,
         }
     }
 
-    /* Check transmit queue */
+    /* Check transmit queue. The buffer stays with the caller so it can be retried */
     if (p_bcb->xmit_q.count >= BNEP_MAX_XMITQ_DEPTH)
-    {
-        GKI_freebuf (p_buf);
         return (BNEP_Q_SIZE_EXCEEDED);
-    }
 
     /* Build the BNEP header */
     bnepu_build_bnep_hdr (p_bcb, p_buf, protocol, p_src_addr, p_dest_addr, fw_ext_present);
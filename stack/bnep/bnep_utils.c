@@ -36,6 +36,14 @@
 /*              L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /********************************************************************************/
 static UINT8 *bnepu_init_hdr (BT_HDR *p_buf, UINT16 hdr_len, UINT8 pkt_type);
+#if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
+static void bnepu_compile_prot_filters (tBNEP_CONN *p_bcb);
+static BOOLEAN bnepu_prot_filter_match (tBNEP_CONN *p_bcb, UINT16 proto);
+#endif
+#if (defined (BNEP_SUPPORTS_MULTI_FILTERS) && BNEP_SUPPORTS_MULTI_FILTERS == TRUE)
+static void bnepu_compile_mcast_filters (tBNEP_CONN *p_bcb);
+static BOOLEAN bnepu_mcast_filter_match (tBNEP_CONN *p_bcb, BD_ADDR p_dest_addr);
+#endif
 
 void bnepu_process_peer_multicast_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filters, UINT16 len);
 void bnepu_send_peer_multicast_filter_rsp (tBNEP_CONN *p_bcb, UINT16 response_code);
@@ -967,6 +975,7 @@ void bnepu_process_peer_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filters, UINT16
         p_bcb->rcvd_prot_filter_start[xx] = start;
         p_bcb->rcvd_prot_filter_end[xx]   = end;
     }
+    bnepu_compile_prot_filters (p_bcb);
 
     bnepu_send_peer_filter_rsp (p_bcb, resp_code);
 #else
@@ -1153,6 +1162,8 @@ void bnepu_process_peer_multicast_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filter
             break;
         }
     }
+    if (p_bcb->rcvd_mcast_filters != 0xFFFF)
+        bnepu_compile_mcast_filters (p_bcb);
 
     BNEP_TRACE_EVENT ("BNEP multicast filters %d", p_bcb->rcvd_mcast_filters);
     bnepu_send_peer_multicast_filter_rsp (p_bcb, resp_code);
@@ -1327,7 +1338,7 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
 #if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
     if (p_bcb->rcvd_num_filters)
     {
-        UINT16          i, proto;
+        UINT16          proto;
 
         /* Findout the actual protocol to check for the filtering */
         proto = protocol;
@@ -1349,14 +1360,7 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
             BE_STREAM_TO_UINT16 (proto, p_data);
         }
 
-        for (i=0; i<p_bcb->rcvd_num_filters; i++)
-        {
-            if ((p_bcb->rcvd_prot_filter_start[i] <= proto) &&
-                (proto <= p_bcb->rcvd_prot_filter_end[i]))
-                break;
-        }
-
-        if (i == p_bcb->rcvd_num_filters)
+        if (!bnepu_prot_filter_match (p_bcb, proto))
         {
             BNEP_TRACE_DEBUG ("Ignoring protocol 0x%x in BNEP data write", proto);
             return BNEP_IGNORE_CMD;
@@ -1369,25 +1373,11 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
     if ((p_dest_addr[0] & 0x01) &&
         p_bcb->rcvd_mcast_filters)
     {
-        UINT16          i;
-
-        /* Check if every multicast should be filtered */
-        if (p_bcb->rcvd_mcast_filters != 0xFFFF)
-        {
-            /* Check if the address is mentioned in the filter range */
-            for (i = 0; i < p_bcb->rcvd_mcast_filters; i++)
-            {
-                if ((memcmp (p_bcb->rcvd_mcast_filter_start[i], p_dest_addr, BD_ADDR_LEN) <= 0) &&
-                    (memcmp (p_bcb->rcvd_mcast_filter_end[i], p_dest_addr, BD_ADDR_LEN) >= 0))
-                    break;
-            }
-        }
-
         /*
         ** If every multicast should be filtered or the address is not in the filter range
         ** drop the packet
         */
-        if ((p_bcb->rcvd_mcast_filters == 0xFFFF) || (i == p_bcb->rcvd_mcast_filters))
+        if ((p_bcb->rcvd_mcast_filters == 0xFFFF) || !bnepu_mcast_filter_match (p_bcb, p_dest_addr))
         {
             BNEP_TRACE_DEBUG ("Ignoring multicast address %x.%x.%x.%x.%x.%x in BNEP data write",
                 p_dest_addr[0], p_dest_addr[1], p_dest_addr[2],
@@ -1401,6 +1391,160 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
 }
 
 
+#if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
+/*******************************************************************************
+**
+** Function         bnepu_compile_prot_filters
+**
+** Description      Sorts the protocol filter ranges received from the peer and
+**                  merges the overlapping and adjacent ones, so that packets
+**                  can be matched with a binary search.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bnepu_compile_prot_filters (tBNEP_CONN *p_bcb)
+{
+    UINT16  *p_start = p_bcb->rcvd_prot_filter_start;
+    UINT16  *p_end   = p_bcb->rcvd_prot_filter_end;
+    UINT16  xx, yy, start, end, num = 0;
+
+    for (xx = 1; xx < p_bcb->rcvd_num_filters; xx++)
+    {
+        start = p_start[xx];
+        end   = p_end[xx];
+        for (yy = xx; (yy > 0) && (p_start[yy - 1] > start); yy--)
+        {
+            p_start[yy] = p_start[yy - 1];
+            p_end[yy]   = p_end[yy - 1];
+        }
+        p_start[yy] = start;
+        p_end[yy]   = end;
+    }
+
+    for (xx = 0; xx < p_bcb->rcvd_num_filters; xx++)
+    {
+        if (num && ((UINT32)p_start[xx] <= (UINT32)p_end[num - 1] + 1))
+        {
+            if (p_end[xx] > p_end[num - 1])
+                p_end[num - 1] = p_end[xx];
+        }
+        else
+        {
+            p_start[num] = p_start[xx];
+            p_end[num]   = p_end[xx];
+            num++;
+        }
+    }
+    p_bcb->rcvd_num_filters = num;
+}
+
+/*******************************************************************************
+**
+** Function         bnepu_prot_filter_match
+**
+** Description      Checks if the protocol falls in one of the compiled peer
+**                  protocol filter ranges.
+**
+** Returns          TRUE if the protocol is allowed
+**
+*******************************************************************************/
+static BOOLEAN bnepu_prot_filter_match (tBNEP_CONN *p_bcb, UINT16 proto)
+{
+    INT16   lo = 0, hi = (INT16)p_bcb->rcvd_num_filters - 1, mid;
+
+    /* Find the last range starting at or below the protocol */
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        if (p_bcb->rcvd_prot_filter_start[mid] <= proto)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return ((hi >= 0) && (proto <= p_bcb->rcvd_prot_filter_end[hi]));
+}
+#endif
+
+#if (defined (BNEP_SUPPORTS_MULTI_FILTERS) && BNEP_SUPPORTS_MULTI_FILTERS == TRUE)
+/*******************************************************************************
+**
+** Function         bnepu_compile_mcast_filters
+**
+** Description      Sorts the multicast address ranges received from the peer
+**                  and merges the overlapping ones for a binary search.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bnepu_compile_mcast_filters (tBNEP_CONN *p_bcb)
+{
+    BD_ADDR start, end;
+    UINT16  xx, yy, num = 0;
+
+    for (xx = 1; xx < p_bcb->rcvd_mcast_filters; xx++)
+    {
+        memcpy (start, p_bcb->rcvd_mcast_filter_start[xx], BD_ADDR_LEN);
+        memcpy (end, p_bcb->rcvd_mcast_filter_end[xx], BD_ADDR_LEN);
+        for (yy = xx; (yy > 0) &&
+             (memcmp (p_bcb->rcvd_mcast_filter_start[yy - 1], start, BD_ADDR_LEN) > 0); yy--)
+        {
+            memcpy (p_bcb->rcvd_mcast_filter_start[yy], p_bcb->rcvd_mcast_filter_start[yy - 1], BD_ADDR_LEN);
+            memcpy (p_bcb->rcvd_mcast_filter_end[yy], p_bcb->rcvd_mcast_filter_end[yy - 1], BD_ADDR_LEN);
+        }
+        memcpy (p_bcb->rcvd_mcast_filter_start[yy], start, BD_ADDR_LEN);
+        memcpy (p_bcb->rcvd_mcast_filter_end[yy], end, BD_ADDR_LEN);
+    }
+
+    for (xx = 0; xx < p_bcb->rcvd_mcast_filters; xx++)
+    {
+        if (num && (memcmp (p_bcb->rcvd_mcast_filter_start[xx],
+                            p_bcb->rcvd_mcast_filter_end[num - 1], BD_ADDR_LEN) <= 0))
+        {
+            if (memcmp (p_bcb->rcvd_mcast_filter_end[xx], p_bcb->rcvd_mcast_filter_end[num - 1], BD_ADDR_LEN) > 0)
+                memcpy (p_bcb->rcvd_mcast_filter_end[num - 1], p_bcb->rcvd_mcast_filter_end[xx], BD_ADDR_LEN);
+        }
+        else
+        {
+            if (num != xx)
+            {
+                memcpy (p_bcb->rcvd_mcast_filter_start[num], p_bcb->rcvd_mcast_filter_start[xx], BD_ADDR_LEN);
+                memcpy (p_bcb->rcvd_mcast_filter_end[num], p_bcb->rcvd_mcast_filter_end[xx], BD_ADDR_LEN);
+            }
+            num++;
+        }
+    }
+    p_bcb->rcvd_mcast_filters = num;
+}
+
+/*******************************************************************************
+**
+** Function         bnepu_mcast_filter_match
+**
+** Description      Checks if the multicast address falls in one of the compiled
+**                  peer multicast filter ranges.
+**
+** Returns          TRUE if the address is allowed
+**
+*******************************************************************************/
+static BOOLEAN bnepu_mcast_filter_match (tBNEP_CONN *p_bcb, BD_ADDR p_dest_addr)
+{
+    INT16   lo = 0, hi = (INT16)p_bcb->rcvd_mcast_filters - 1, mid;
+
+    /* Find the last range starting at or below the address */
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        if (memcmp (p_bcb->rcvd_mcast_filter_start[mid], p_dest_addr, BD_ADDR_LEN) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return ((hi >= 0) && (memcmp (p_bcb->rcvd_mcast_filter_end[hi], p_dest_addr, BD_ADDR_LEN) >= 0));
+}
+#endif
+
+
 
 
 
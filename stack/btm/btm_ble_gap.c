@@ -1108,8 +1108,12 @@ UINT8 *BTM_CheckAdvData( UINT8 *p_adv, UINT8 type, UINT8 *p_length)
     UINT8 *p = p_adv;
     UINT8 length;
     UINT8 adv_type;
+    tBTM_AD_IDX *p_idx;
     BTM_TRACE_API("BTM_CheckAdvData type=0x%02X", type);
 
+    if ((p_idx = btm_ad_idx_lookup(p_adv)) != NULL)
+        return btm_ad_idx_find(p_idx, type, p_length);
+
     STREAM_TO_UINT8(length, p);
 
     while ( length && (p - p_adv <= BTM_BLE_ADV_DATA_LEN_MAX))
@@ -2050,6 +2054,8 @@ void btm_ble_cache_adv_data(tBTM_INQ_RESULTS *p_cur, UINT8 data_len, UINT8 *p, U
         }
     }
 
+    btm_ad_idx_build(&p_le_inq_cb->adv_idx, p_le_inq_cb->adv_data_cache, p_le_inq_cb->adv_len);
+
     /* parse service UUID from adv packet and save it in inq db eir_uuid */
     /* TODO */
 }
@@ -2093,7 +2099,7 @@ UINT8 btm_ble_is_discoverable(BD_ADDR bda, UINT8 evt_type, UINT8 *p)
 
     if (p_le_inq_cb->adv_len != 0)
     {
-        if ((p_flag = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache,
+        if ((p_flag = btm_ad_idx_find(&p_le_inq_cb->adv_idx,
             BTM_BLE_AD_TYPE_FLAG, &data_len)) != NULL)
         {
             flag = * p_flag;
@@ -2307,7 +2313,7 @@ BOOLEAN btm_ble_update_inq_result(tINQ_DB_ENT *p_i, UINT8 addr_type, UINT8 evt_t
 
     if (p_le_inq_cb->adv_len != 0)
     {
-        if ((p_flag = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache, BTM_BLE_AD_TYPE_FLAG, &len)) != NULL)
+        if ((p_flag = btm_ad_idx_find(&p_le_inq_cb->adv_idx, BTM_BLE_AD_TYPE_FLAG, &len)) != NULL)
             p_cur->flag = * p_flag;
     }
 
@@ -2317,14 +2323,14 @@ BOOLEAN btm_ble_update_inq_result(tINQ_DB_ENT *p_i, UINT8 addr_type, UINT8 evt_t
          * then try to convert the appearance value to a class of device value Bluedroid can use.
          * Otherwise fall back to trying to infer if it is a HID device based on the service class.
          */
-        p_uuid16 = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache, BTM_BLE_AD_TYPE_APPEARANCE, &len);
+        p_uuid16 = btm_ad_idx_find(&p_le_inq_cb->adv_idx, BTM_BLE_AD_TYPE_APPEARANCE, &len);
         if (p_uuid16 && len == 2)
         {
             btm_ble_appearance_to_cod((UINT16)p_uuid16[0] | (p_uuid16[1] << 8), p_cur->dev_class);
         }
         else
         {
-            if ((p_uuid16 = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache,
+            if ((p_uuid16 = btm_ad_idx_find(&p_le_inq_cb->adv_idx,
                                              BTM_BLE_AD_TYPE_16SRV_CMPL, &len)) != NULL)
             {
                 UINT8 i;
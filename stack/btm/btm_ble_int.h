@@ -144,6 +144,7 @@ typedef struct
 
     UINT8            adv_len;
     UINT8            adv_data_cache[BTM_BLE_CACHE_ADV_DATA_MAX];
+    tBTM_AD_IDX      adv_idx;           /* index of adv_data_cache */
 
     /* inquiry BD addr database */
     UINT8               num_bd_entries;
@@ -773,6 +773,9 @@ void btm_read_hci_buf_size_complete (UINT8 *p, UINT16 evt_len)
         STREAM_TO_UINT16 (lm_num_sco_bufs,   p);
 
         btu_cb.hcit_acl_pkt_size = btu_cb.hcit_acl_data_size + HCI_DATA_PREAMBLE_SIZE;
+#if BTM_SCO_HCI_INCLUDED == TRUE
+        btm_cb.sco_cb.num_sco_bufs = lm_num_sco_bufs;
+#endif
 
         l2c_link_processs_num_bufs (lm_num_acl_bufs);
 
@@ -47,6 +47,14 @@
 /********************************************************************************/
 /*                 L O C A L    D A T A    D E F I N I T I O N S                */
 /********************************************************************************/
+/* inquiry database entry from its index + 1, and back */
+#define BTM_INQ_DB_ENT(i)       (&btm_cb.btm_inq_vars.inq_db[(i) - 1])
+#define BTM_INQ_DB_IDX(p)       ((UINT16)((p) - btm_cb.btm_inq_vars.inq_db) + 1)
+
+/* hash bucket of a BD address, from the LAP which is the least structured part */
+#define BTM_INQ_DB_BUCKET(bda)  ((((UINT16)(bda)[3] << 8 | (bda)[4]) ^ ((UINT16)(bda)[5] * 0x9D)) & \
+                                 (BTM_INQ_DB_HASH_SIZE - 1))
+
 static const LAP general_inq_lap = {0x9e,0x8b,0x33};
 static const LAP limited_inq_lap = {0x9e,0x8b,0x00};
 
@@ -145,6 +153,10 @@ extern UINT16 BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES];
 static void         btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq);
 static tBTM_STATUS  btm_set_inq_event_filter (UINT8 filter_cond_type, tBTM_INQ_FILT_COND *p_filt_cond);
 static void         btm_clr_inq_result_flt (void);
+static void         btm_inq_db_hash_add (UINT16 idx);
+static void         btm_inq_db_hash_remove (UINT16 idx);
+static void         btm_inq_db_lru_add (UINT16 idx);
+static void         btm_inq_db_lru_remove (UINT16 idx);
 
 #if ((BTM_EIR_SERVER_INCLUDED == TRUE)||(BTM_EIR_CLIENT_INCLUDED == TRUE))
 static UINT8        btm_convert_uuid_to_eir_service( UINT16 uuid16 );
@@ -1176,18 +1188,16 @@ tBTM_STATUS  BTM_CancelRemoteDeviceName (void)
 *******************************************************************************/
 tBTM_INQ_INFO *BTM_InqFirstResult (void)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-    UINT32       cur_inq_count = btm_cb.btm_inq_vars.inq_counter - 1;
+    tBTM_INQ_INFO *p_cur = BTM_InqDbFirst();
+    tINQ_DB_ENT   *p_ent;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_cur)
     {
-        if (p_ent->in_use && p_ent->inq_count == cur_inq_count)
-            return (&p_ent->inq_info);
+        p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
+        if (p_ent->inq_count != btm_cb.btm_inq_vars.inq_counter - 1)
+            p_cur = BTM_InqNextResult(p_cur);
     }
-
-    /* If here, no used entry found */
-    return ((tBTM_INQ_INFO *)NULL);
+    return (p_cur);
 }
 
 
@@ -1205,21 +1215,18 @@ tBTM_INQ_INFO *BTM_InqFirstResult (void)
 tBTM_INQ_INFO *BTM_InqNextResult (tBTM_INQ_INFO *p_cur)
 {
     tINQ_DB_ENT  *p_ent;
-    UINT16        inx;
     UINT32        cur_inq_count = btm_cb.btm_inq_vars.inq_counter - 1;
 
     if (p_cur)
     {
-        p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
-        inx = (UINT16)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
-
-        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE; inx++, p_ent++)
+        while ((p_cur = BTM_InqDbNext(p_cur)) != NULL)
         {
-            if (p_ent->in_use && p_ent->inq_count == cur_inq_count)
-                return (&p_ent->inq_info);
+            p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
+            if (p_ent->inq_count == cur_inq_count)
+                return (p_cur);
         }
 
-        /* If here, more entries found */
+        /* If here, no more entries found */
         return ((tBTM_INQ_INFO *)NULL);
     }
     else
@@ -1240,15 +1247,18 @@ tBTM_INQ_INFO *BTM_InqNextResult (tBTM_INQ_INFO *p_cur)
 *******************************************************************************/
 tBTM_INQ_INFO *BTM_InqDbRead (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
+    UINT16       idx;
+    tINQ_DB_ENT  *p_ent;
 
     BTM_TRACE_API ("BTM_InqDbRead: bd addr [%02x%02x%02x%02x%02x%02x]",
                p_bda[0], p_bda[1], p_bda[2], p_bda[3], p_bda[4], p_bda[5]);
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    /* a read does not count as a use of the entry */
+    for (idx = btm_cb.btm_inq_vars.inq_db_hash[BTM_INQ_DB_BUCKET(p_bda)];
+         idx != BTM_INQ_DB_NONE; idx = p_ent->hash_next)
     {
-        if ((p_ent->in_use) && (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
+        p_ent = BTM_INQ_DB_ENT(idx);
+        if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))
             return (&p_ent->inq_info);
     }
 
@@ -1271,17 +1281,7 @@ tBTM_INQ_INFO *BTM_InqDbRead (BD_ADDR p_bda)
 *******************************************************************************/
 tBTM_INQ_INFO *BTM_InqDbFirst (void)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
-    {
-        if (p_ent->in_use)
-            return (&p_ent->inq_info);
-    }
-
-    /* If here, no used entry found */
-    return ((tBTM_INQ_INFO *)NULL);
+    return (BTM_InqDbNext(NULL));
 }
 
 
@@ -1299,24 +1299,23 @@ tBTM_INQ_INFO *BTM_InqDbFirst (void)
 tBTM_INQ_INFO *BTM_InqDbNext (tBTM_INQ_INFO *p_cur)
 {
     tINQ_DB_ENT  *p_ent;
-    UINT16        inx;
+    UINT16        inx = 0;
 
     if (p_cur)
     {
         p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
-        inx = (UINT16)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
-
-        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE; inx++, p_ent++)
-        {
-            if (p_ent->in_use)
-                return (&p_ent->inq_info);
-        }
+        inx = (UINT16)(p_ent - btm_cb.btm_inq_vars.inq_db) + 1;
+    }
 
-        /* If here, more entries found */
-        return ((tBTM_INQ_INFO *)NULL);
+    /* entries from inq_db_top on were never used */
+    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < btm_cb.btm_inq_vars.inq_db_top; inx++, p_ent++)
+    {
+        if (p_ent->in_use)
+            return (&p_ent->inq_info);
     }
-    else
-        return (BTM_InqDbFirst());
+
+    /* If here, no more entries found */
+    return ((tBTM_INQ_INFO *)NULL);
 }
 
 
@@ -1356,19 +1355,9 @@ tBTM_STATUS BTM_ClearInqDb (BD_ADDR p_bda)
 ** Returns          This function returns the number of entries in the inquiry database.
 **
 *******************************************************************************/
-UINT8 BTM_ReadNumInqDbEntries (void)
+UINT16 BTM_ReadNumInqDbEntries (void)
 {
-    UINT8         num_entries;
-    UINT8         num_results;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-
-    for (num_entries = 0, num_results = 0; num_entries < BTM_INQ_DB_SIZE; num_entries++, p_ent++)
-    {
-        if (p_ent->in_use)
-            num_results++;
-    }
-
-    return (num_results);
+    return (btm_cb.btm_inq_vars.inq_db_num);
 }
 
 
@@ -1641,20 +1630,41 @@ void btm_inq_clear_ssp(void)
 void btm_clr_inq_db (BD_ADDR p_bda)
 {
     tBTM_INQUIRY_VAR_ST     *p_inq = &btm_cb.btm_inq_vars;
-    tINQ_DB_ENT             *p_ent = p_inq->inq_db;
+    tINQ_DB_ENT             *p_ent;
     UINT16                   xx;
 
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("btm_clr_inq_db: inq_active:0x%x state:%d",
         btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_bda != NULL)
     {
-        if (p_ent->in_use)
+        for (xx = p_inq->inq_db_hash[BTM_INQ_DB_BUCKET(p_bda)]; xx != BTM_INQ_DB_NONE; xx = p_ent->hash_next)
+        {
+            p_ent = BTM_INQ_DB_ENT(xx);
+            if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))
+            {
+                btm_inq_db_hash_remove(xx);
+                btm_inq_db_lru_remove(xx);
+                p_ent->in_use = FALSE;
+#if (BTM_INQ_GET_REMOTE_NAME == TRUE)
+                p_ent->inq_info.remote_name_state = BTM_INQ_RMT_NAME_EMPTY;
+#endif
+                p_ent->hash_next = p_inq->inq_db_free;
+                p_inq->inq_db_free = xx;
+                p_inq->inq_db_num--;
+
+                if (btm_cb.btm_inq_vars.p_inq_change_cb)
+                    (*btm_cb.btm_inq_vars.p_inq_change_cb) (&p_ent->inq_info, FALSE);
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (xx = 0, p_ent = p_inq->inq_db; xx < p_inq->inq_db_top; xx++, p_ent++)
         {
-            /* If this is the specified BD_ADDR or clearing all devices */
-            if (p_bda == NULL ||
-                (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
+            if (p_ent->in_use)
             {
                 p_ent->in_use = FALSE;
 #if (BTM_INQ_GET_REMOTE_NAME == TRUE)
@@ -1665,6 +1675,13 @@ void btm_clr_inq_db (BD_ADDR p_bda)
                     (*btm_cb.btm_inq_vars.p_inq_change_cb) (&p_ent->inq_info, FALSE);
             }
         }
+
+        memset (p_inq->inq_db_hash, 0, sizeof (p_inq->inq_db_hash));
+        p_inq->inq_db_mru  = BTM_INQ_DB_NONE;
+        p_inq->inq_db_lru  = BTM_INQ_DB_NONE;
+        p_inq->inq_db_free = BTM_INQ_DB_NONE;
+        p_inq->inq_db_top  = 0;
+        p_inq->inq_db_num  = 0;
     }
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("inq_active:0x%x state:%d",
@@ -1738,25 +1755,130 @@ BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
     return (FALSE);
 }
 
+/*******************************************************************************
+**
+** Function         btm_inq_db_hash_add
+**
+** Description      This function adds an entry to the bucket of its address.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_hash_add (UINT16 idx)
+{
+    tINQ_DB_ENT  *p_ent = BTM_INQ_DB_ENT(idx);
+    UINT16       *p_head = &btm_cb.btm_inq_vars.inq_db_hash[BTM_INQ_DB_BUCKET(p_ent->inq_info.results.remote_bd_addr)];
+
+    p_ent->hash_next = *p_head;
+    *p_head = idx;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_hash_remove
+**
+** Description      This function removes an entry from the bucket of its
+**                  address.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_hash_remove (UINT16 idx)
+{
+    tINQ_DB_ENT  *p_ent = BTM_INQ_DB_ENT(idx);
+    UINT16       *p_link = &btm_cb.btm_inq_vars.inq_db_hash[BTM_INQ_DB_BUCKET(p_ent->inq_info.results.remote_bd_addr)];
+
+    while (*p_link != BTM_INQ_DB_NONE)
+    {
+        if (*p_link == idx)
+        {
+            *p_link = p_ent->hash_next;
+            break;
+        }
+        p_link = &BTM_INQ_DB_ENT(*p_link)->hash_next;
+    }
+    p_ent->hash_next = BTM_INQ_DB_NONE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_add
+**
+** Description      This function makes an entry the most recently used one.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_lru_add (UINT16 idx)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent = BTM_INQ_DB_ENT(idx);
+
+    p_ent->lru_prev = BTM_INQ_DB_NONE;
+    p_ent->lru_next = p_inq->inq_db_mru;
+    if (p_inq->inq_db_mru != BTM_INQ_DB_NONE)
+        BTM_INQ_DB_ENT(p_inq->inq_db_mru)->lru_prev = idx;
+    else
+        p_inq->inq_db_lru = idx;
+    p_inq->inq_db_mru = idx;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_remove
+**
+** Description      This function takes an entry out of the use order.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_lru_remove (UINT16 idx)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent = BTM_INQ_DB_ENT(idx);
+
+    if (p_ent->lru_prev != BTM_INQ_DB_NONE)
+        BTM_INQ_DB_ENT(p_ent->lru_prev)->lru_next = p_ent->lru_next;
+    else
+        p_inq->inq_db_mru = p_ent->lru_next;
+
+    if (p_ent->lru_next != BTM_INQ_DB_NONE)
+        BTM_INQ_DB_ENT(p_ent->lru_next)->lru_prev = p_ent->lru_prev;
+    else
+        p_inq->inq_db_lru = p_ent->lru_prev;
+
+    p_ent->lru_prev = p_ent->lru_next = BTM_INQ_DB_NONE;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_inq_db_find
 **
 ** Description      This function looks through the inquiry database for a match
-**                  based on Bluetooth Device Address
+**                  based on Bluetooth Device Address.  A match becomes the most
+**                  recently used entry.
 **
 ** Returns          pointer to entry, or NULL if not found
 **
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
+    UINT16       idx;
+    tINQ_DB_ENT  *p_ent;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (idx = btm_cb.btm_inq_vars.inq_db_hash[BTM_INQ_DB_BUCKET(p_bda)];
+         idx != BTM_INQ_DB_NONE; idx = p_ent->hash_next)
     {
-        if ((p_ent->in_use) && (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
+        p_ent = BTM_INQ_DB_ENT(idx);
+        if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))
+        {
+            if (btm_cb.btm_inq_vars.inq_db_mru != idx)
+            {
+                btm_inq_db_lru_remove(idx);
+                btm_inq_db_lru_add(idx);
+            }
             return (p_ent);
+        }
     }
 
     /* If here, not found */
@@ -1768,57 +1890,55 @@ tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
 **
 ** Function         btm_inq_db_new
 **
-** Description      This function looks through the inquiry database for an unused
-**                  entry. If no entry is free, it allocates the oldest entry.
+** Description      This function gets an unused entry of the inquiry database.
+**                  If no entry is free, it reuses the least recently used one.
 **
 ** Returns          pointer to entry
 **
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_new (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT  *p_old = btm_cb.btm_inq_vars.inq_db;
-    UINT32       ot = 0xFFFFFFFF;
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent;
+    UINT16               idx;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_inq->inq_db_free != BTM_INQ_DB_NONE)
     {
-        if (!p_ent->in_use)
-        {
-            memset (p_ent, 0, sizeof (tINQ_DB_ENT));
-            memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-            p_ent->in_use = TRUE;
-
-#if (BTM_INQ_GET_REMOTE_NAME==TRUE)
-            p_ent->inq_info.remote_name_state = BTM_INQ_RMT_NAME_EMPTY;
-#endif
-
-            return (p_ent);
-        }
-
-        if (p_ent->time_of_resp < ot)
-        {
-            p_old = p_ent;
-            ot    = p_ent->time_of_resp;
-        }
+        idx = p_inq->inq_db_free;
+        p_inq->inq_db_free = BTM_INQ_DB_ENT(idx)->hash_next;
+        p_inq->inq_db_num++;
     }
+    else if (p_inq->inq_db_top < BTM_INQ_DB_SIZE)
+    {
+        idx = ++p_inq->inq_db_top;
+        p_inq->inq_db_num++;
+    }
+    else
+    {
+        /* If here, no free entry found. Reuse the least recently used. */
+        idx = p_inq->inq_db_lru;
+        btm_inq_db_hash_remove(idx);
+        btm_inq_db_lru_remove(idx);
 
-    /* If here, no free entry found. Return the oldest. */
-
-    /* Before deleting the oldest, if anyone is registered for change */
-    /* notifications, then tell him we are deleting an entry.         */
-    if (btm_cb.btm_inq_vars.p_inq_change_cb)
-        (*btm_cb.btm_inq_vars.p_inq_change_cb) (&p_old->inq_info, FALSE);
+        /* Before deleting it, if anyone is registered for change */
+        /* notifications, then tell him we are deleting an entry.  */
+        if (p_inq->p_inq_change_cb)
+            (*p_inq->p_inq_change_cb) (&BTM_INQ_DB_ENT(idx)->inq_info, FALSE);
+    }
 
-    memset (p_old, 0, sizeof (tINQ_DB_ENT));
-    memcpy (p_old->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-    p_old->in_use = TRUE;
+    p_ent = BTM_INQ_DB_ENT(idx);
+    memset (p_ent, 0, sizeof (tINQ_DB_ENT));
+    memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
+    p_ent->in_use = TRUE;
 
 #if (BTM_INQ_GET_REMOTE_NAME==TRUE)
-    p_old->inq_info.remote_name_state = BTM_INQ_RMT_NAME_EMPTY;
+    p_ent->inq_info.remote_name_state = BTM_INQ_RMT_NAME_EMPTY;
 #endif
 
-    return (p_old);
+    btm_inq_db_hash_add(idx);
+    btm_inq_db_lru_add(idx);
+
+    return (p_ent);
 }
 
 
@@ -2243,8 +2363,6 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
             BTM_TRACE_WARNING ("btm_process_inq_results: Dev class: %02x-%02x-%02x",
                         p_cur->dev_class[0], p_cur->dev_class[1], p_cur->dev_class[2]);
 
-            p_i->time_of_resp = GKI_get_tick_count ();
-
             if (p_i->inq_count != p_inq->inq_counter)
                 p_inq->inq_cmpl_info.num_resp++;       /* A new response was found */
 
@@ -2293,6 +2411,13 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 
         if (is_new || update)
         {
+#if (BTM_EIR_CLIENT_INCLUDED == TRUE)
+            /* index the EIR once, the lookups below and those of the result
+            ** callbacks use it until the result is done */
+            if( inq_res_mode == BTM_INQ_RESULT_EXTENDED )
+                btm_ad_idx_build( &p_inq->eir_idx, p, HCI_EXT_INQ_RESPONSE_LEN );
+#endif
+
 #if (BTM_INQ_GET_REMOTE_NAME==TRUE)
 #if (BTM_EIR_CLIENT_INCLUDED == TRUE)
             if( inq_res_mode == BTM_INQ_RESULT_EXTENDED )
@@ -2349,6 +2474,11 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
             /* If anyone is registered for change notifications, then tell him we added an entry.  */
             if (p_inq->p_inq_change_cb)
                 (*p_inq->p_inq_change_cb) (&p_i->inq_info, TRUE);
+
+#if (BTM_EIR_CLIENT_INCLUDED == TRUE)
+            /* the event buffer is about to be reused */
+            p_inq->eir_idx.p_data = NULL;
+#endif
         }
     }
 }
@@ -2365,33 +2495,64 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 *******************************************************************************/
 void btm_sort_inq_result(void)
 {
-    UINT8               xx, yy, num_resp;
-    tINQ_DB_ENT         *p_tmp  = NULL;
-    tINQ_DB_ENT         *p_ent  = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT         *p_next = btm_cb.btm_inq_vars.inq_db+1;
-    int                 size;
-
-    num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp<BTM_INQ_DB_SIZE)?
-                btm_cb.btm_inq_vars.inq_cmpl_info.num_resp: BTM_INQ_DB_SIZE;
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT32              cur_inq_count = p_inq->inq_counter - 1;
+    UINT16              *p_slot;
+    tINQ_DB_ENT         *p_tmp;
+    tINQ_DB_ENT         *p_ent;
+    tINQ_DB_ENT         *p_next;
+    UINT16              xx, yy, num_resp = 0;
+    UINT16              lru_prev, lru_next;
+
+    if (p_inq->inq_db_num < 2)
+        return;
 
-    if((p_tmp = (tINQ_DB_ENT *)GKI_getbuf(sizeof(tINQ_DB_ENT))) != NULL)
+    /* the entries of the last inquiry keep their slots, their contents are
+       ordered by rssi so the database is walked strongest first */
+    p_slot = (UINT16 *)GKI_getbuf((UINT16)(p_inq->inq_db_num * sizeof(UINT16)));
+    p_tmp  = (tINQ_DB_ENT *)GKI_getbuf(sizeof(tINQ_DB_ENT));
+    if (p_slot != NULL && p_tmp != NULL)
     {
-        size = sizeof(tINQ_DB_ENT);
-        for(xx = 0; xx < num_resp-1; xx++, p_ent++)
+        for (xx = 0, p_ent = p_inq->inq_db; xx < p_inq->inq_db_top; xx++, p_ent++)
         {
-            for(yy = xx+1, p_next = p_ent+1; yy < num_resp; yy++, p_next++)
+            if (p_ent->in_use && p_ent->inq_count == cur_inq_count)
+                p_slot[num_resp++] = xx + 1;
+        }
+
+        for (xx = 0; xx + 1 < num_resp; xx++)
+        {
+            p_ent = BTM_INQ_DB_ENT(p_slot[xx]);
+            for (yy = xx + 1; yy < num_resp; yy++)
             {
-                if(p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi)
+                p_next = BTM_INQ_DB_ENT(p_slot[yy]);
+                if (p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi)
                 {
-                    memcpy (p_tmp,  p_next, size);
-                    memcpy (p_next, p_ent,  size);
-                    memcpy (p_ent,  p_tmp,  size);
+                    /* the hash chains follow the address, the use order stays
+                       with the slot */
+                    btm_inq_db_hash_remove(p_slot[xx]);
+                    btm_inq_db_hash_remove(p_slot[yy]);
+                    lru_prev = p_ent->lru_prev;
+                    lru_next = p_ent->lru_next;
+
+                    memcpy (p_tmp,  p_next, sizeof(tINQ_DB_ENT));
+                    memcpy (p_next, p_ent,  sizeof(tINQ_DB_ENT));
+                    memcpy (p_ent,  p_tmp,  sizeof(tINQ_DB_ENT));
+
+                    p_next->lru_prev = p_ent->lru_prev;
+                    p_next->lru_next = p_ent->lru_next;
+                    p_ent->lru_prev  = lru_prev;
+                    p_ent->lru_next  = lru_next;
+                    btm_inq_db_hash_add(p_slot[xx]);
+                    btm_inq_db_hash_add(p_slot[yy]);
                 }
             }
         }
+    }
 
+    if (p_slot != NULL)
+        GKI_freebuf(p_slot);
+    if (p_tmp != NULL)
         GKI_freebuf(p_tmp);
-    }
 }
 
 /*******************************************************************************
@@ -2947,6 +3108,104 @@ tBTM_STATUS BTM_WriteEIR( BT_HDR *p_buff )
 #endif
 }
 
+/*******************************************************************************
+**
+** Function         btm_ad_idx_build
+**
+** Description      This function indexes the data structures of EIR or
+**                  advertising data in one pass. Parsing stops at the first
+**                  zero length; a structure running past data_len is
+**                  malformed and is not indexed.
+**
+** Parameters       p_idx - index to build
+**                  p_data - EIR or advertising data
+**                  data_len - size of p_data
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_ad_idx_build (tBTM_AD_IDX *p_idx, UINT8 *p_data, UINT16 data_len)
+{
+    UINT16  offset = 0;
+    UINT8   length;
+
+    p_idx->p_data = p_data;
+    p_idx->num = 0;
+
+    while ((offset < data_len) && (p_idx->num < BTM_AD_IDX_MAX))
+    {
+        length = p_data[offset];
+        if ((length == 0) || (offset + 1 + length > data_len))
+            break;
+
+        p_idx->type[p_idx->num] = p_data[offset + 1];
+        p_idx->offset[p_idx->num] = (UINT8) offset;
+        p_idx->num++;
+
+        offset += length + 1;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_idx_find
+**
+** Description      This function gets the first data structure of a type
+**                  from an index.
+**
+** Parameters       p_idx - index built by btm_ad_idx_build
+**                  type - data type to find
+**                  p_length - return the length of the data not including type
+**
+** Returns          pointer of the data, NULL if not found
+**
+*******************************************************************************/
+UINT8 *btm_ad_idx_find (tBTM_AD_IDX *p_idx, UINT8 type, UINT8 *p_length)
+{
+    UINT8   *p;
+    UINT8   xx;
+
+    for (xx = 0; xx < p_idx->num; xx++)
+    {
+        if (p_idx->type[xx] == type)
+        {
+            p = p_idx->p_data + p_idx->offset[xx];
+            *p_length = p[0] - 1;   /* minus the length of type */
+            return p + 2;
+        }
+    }
+
+    *p_length = 0;
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_idx_lookup
+**
+** Description      This function gets the index of a buffer holding the EIR
+**                  of the inquiry result being processed or the cached
+**                  advertising data.
+**
+** Returns          pointer of the index, NULL if p_data is not indexed
+**
+*******************************************************************************/
+tBTM_AD_IDX *btm_ad_idx_lookup (UINT8 *p_data)
+{
+    if (p_data == NULL)
+        return NULL;
+
+    if (p_data == btm_cb.btm_inq_vars.eir_idx.p_data)
+        return &btm_cb.btm_inq_vars.eir_idx;
+
+#if BLE_INCLUDED == TRUE
+    if (p_data == btm_cb.ble_ctr_cb.inq_var.adv_idx.p_data)
+        return &btm_cb.ble_ctr_cb.inq_var.adv_idx;
+#endif
+
+    return NULL;
+}
+
 /*******************************************************************************
 **
 ** Function         BTM_CheckEirData
@@ -2966,8 +3225,12 @@ UINT8 *BTM_CheckEirData( UINT8 *p_eir, UINT8 type, UINT8 *p_length )
     UINT8 *p = p_eir;
     UINT8 length;
     UINT8 eir_type;
+    tBTM_AD_IDX *p_idx;
     BTM_TRACE_API("BTM_CheckEirData type=0x%02X", type);
 
+    if ((p_idx = btm_ad_idx_lookup(p_eir)) != NULL)
+        return btm_ad_idx_find(p_idx, type, p_length);
+
     STREAM_TO_UINT8(length, p);
     while( length && (p - p_eir <= HCI_EXT_INQ_RESPONSE_LEN))
     {
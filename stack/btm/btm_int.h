@@ -35,6 +35,20 @@
 
 #include "btm_api.h"
 
+/* Index of the data structures of one EIR or advertising data buffer. It is
+** built in a single pass when a report is received so that looking up each
+** data type does not rescan the buffer.
+*/
+#define BTM_AD_IDX_MAX      (HCI_EXT_INQ_RESPONSE_LEN / 2)
+
+typedef struct
+{
+    UINT8       *p_data;                    /* indexed buffer, NULL if none */
+    UINT8       num;                        /* number of data structures */
+    UINT8       type[BTM_AD_IDX_MAX];       /* data type of each structure */
+    UINT8       offset[BTM_AD_IDX_MAX];     /* offset of its length octet */
+} tBTM_AD_IDX;
+
 #if (BLE_INCLUDED == TRUE)
 #include "btm_ble_int.h"
 #if (SMP_INCLUDED == TRUE)
@@ -267,9 +281,11 @@ typedef struct
 } tINQ_BDADDR;
 #endif
 
+/* Inquiry database entries are linked by index + 1, 0 ends a list */
+#define BTM_INQ_DB_NONE     0
+
 typedef struct
 {
-    UINT32          time_of_resp;
     UINT32          inq_count;          /* "timestamps" the entry with a particular inquiry count   */
                                         /* Used for determining if a response has already been      */
                                         /* received for the current inquiry operation. (We do not   */
@@ -281,6 +297,9 @@ typedef struct
 #if (BLE_INCLUDED == TRUE)
     BOOLEAN         scan_rsp;
 #endif
+    UINT16          hash_next;          /* next entry in the hash bucket, or in the free list */
+    UINT16          lru_prev;           /* more recently used entry */
+    UINT16          lru_next;           /* less recently used entry */
 } tINQ_DB_ENT;
 
 
@@ -334,6 +353,13 @@ typedef struct
     UINT16           max_bd_entries;        /* Maximum number of entries that can be stored */
 #endif
     tINQ_DB_ENT      inq_db[BTM_INQ_DB_SIZE];
+    UINT16           inq_db_hash[BTM_INQ_DB_HASH_SIZE]; /* first entry of each bucket */
+    UINT16           inq_db_mru;            /* most recently used entry */
+    UINT16           inq_db_lru;            /* least recently used entry, replaced first */
+    UINT16           inq_db_free;           /* released entries */
+    UINT16           inq_db_top;            /* entries from here on were never used */
+    UINT16           inq_db_num;            /* number of entries in use */
+    tBTM_AD_IDX      eir_idx;               /* EIR of the result being processed */
     tBTM_INQ_PARMS   inqparms;              /* Contains the parameters for the current inquiry */
     tBTM_INQUIRY_CMPL inq_cmpl_info;        /* Status and number of responses from the last inquiry */
 
@@ -424,6 +450,11 @@ typedef struct
     tBTM_ESCO_INFO   esco;              /* Current settings             */
 #if BTM_SCO_HCI_INCLUDED == TRUE
     BUFFER_Q         xmit_data_q;       /* SCO data transmitting queue  */
+    UINT16           xmit_credits;      /* Packets the controller can take now */
+    UINT32           xmit_pkts;         /* Statistics, logged on disconnection */
+    UINT32           xmit_drops;
+    UINT32           rcv_pkts;
+    UINT32           rcv_errs;
 #endif
     tBTM_SCO_CB     *p_conn_cb;         /* Callback for when connected  */
     tBTM_SCO_CB     *p_disc_cb;         /* Callback for when disconnect */
@@ -441,6 +472,7 @@ typedef struct
 #if BTM_SCO_HCI_INCLUDED == TRUE
     tBTM_SCO_DATA_CB     *p_data_cb;        /* Callback for SCO data over HCI */
     UINT32               xmit_window_size; /* Total SCO window in bytes  */
+    UINT16               num_sco_bufs;      /* Controller SCO buffers, from Read Buffer Size */
 #endif
     tSCO_CONN            sco_db[BTM_MAX_SCO_LINKS];
     tBTM_ESCO_PARAMS     def_esco_parms;
@@ -464,6 +496,9 @@ extern void     btm_accept_sco_link(UINT16 sco_inx, tBTM_ESCO_PARAMS *p_setup,
                                     tBTM_SCO_CB *p_conn_cb, tBTM_SCO_CB *p_disc_cb);
 extern void     btm_reject_sco_link(UINT16 sco_inx );
 extern void btm_sco_chk_pend_rolechange (UINT16 hci_handle);
+#if BTM_SCO_HCI_INCLUDED == TRUE
+extern UINT16 btm_sco_max_xmit_credits (void);
+#endif
 extern void btm_sco_disc_chk_pend_for_modechange (UINT16 hci_handle);
 
 #else
@@ -994,6 +1029,9 @@ extern void         btm_event_filter_complete (UINT8 *p);
 extern void         btm_inq_stop_on_ssp(void);
 extern void         btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda);
+extern void         btm_ad_idx_build (tBTM_AD_IDX *p_idx, UINT8 *p_data, UINT16 data_len);
+extern UINT8       *btm_ad_idx_find (tBTM_AD_IDX *p_idx, UINT8 type, UINT8 *p_length);
+extern tBTM_AD_IDX *btm_ad_idx_lookup (UINT8 *p_data);
 extern BOOLEAN      btm_inq_find_bdaddr (BD_ADDR p_bda);
 
 #if (BTM_EIR_CLIENT_INCLUDED == TRUE)
@@ -94,6 +94,15 @@ void btm_sco_flush_sco_data(UINT16 sco_inx)
             if ((p_buf = (BT_HDR *)GKI_dequeue (&p->xmit_data_q)) != NULL)
                 GKI_freebuf (p_buf);
         }
+
+        if (p->xmit_pkts || p->rcv_pkts)
+        {
+            BTM_TRACE_EVENT ("BTM SCO [%d] tx %u (dropped %u), rx %u (errors %u)", sco_inx,
+                p->xmit_pkts, p->xmit_drops, p->rcv_pkts, p->rcv_errs);
+        }
+        p->xmit_credits = 0;
+        p->xmit_pkts = p->xmit_drops = 0;
+        p->rcv_pkts = p->rcv_errs = 0;
     }
 #else
     UNUSED(sco_inx);
@@ -239,12 +248,31 @@ static void btm_esco_conn_rsp (UINT16 sco_inx, UINT8 hci_status, BD_ADDR bda,
 
 
 #if BTM_SCO_HCI_INCLUDED == TRUE
+/*******************************************************************************
+**
+** Function         btm_sco_max_xmit_credits
+**
+** Description      Number of SCO packets which may be outstanding in the
+**                  controller.
+**
+** Returns          UINT16
+**
+*******************************************************************************/
+UINT16 btm_sco_max_xmit_credits (void)
+{
+    UINT16 num_bufs = btm_cb.sco_cb.num_sco_bufs;
+
+    return (num_bufs && num_bufs < BTM_SCO_INIT_XMIT_CREDIT) ? num_bufs : BTM_SCO_INIT_XMIT_CREDIT;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_sco_check_send_pkts
 **
 ** Description      This function is called to check if it can send packets
-**                  to the Host Controller.
+**                  to the Host Controller. A packet is only sent for each
+**                  credit, credits are returned as packets are received so
+**                  the host is paced by the air interface.
 **
 ** Returns          void
 **
@@ -256,7 +284,7 @@ void btm_sco_check_send_pkts (UINT16 sco_inx)
     tSCO_CONN   *p_ccb = &p_cb->sco_db[sco_inx];
 
     /* If there is data to send, send it now */
-    while (p_ccb->xmit_data_q.p_first != NULL)
+    while (p_ccb->xmit_data_q.p_first != NULL && p_ccb->xmit_credits)
     {
         p_buf = NULL;
 
@@ -265,6 +293,8 @@ void btm_sco_check_send_pkts (UINT16 sco_inx)
 #endif
         p_buf = (BT_HDR *)GKI_dequeue (&p_ccb->xmit_data_q);
 
+        p_ccb->xmit_credits--;
+        p_ccb->xmit_pkts++;
         HCI_SCO_DATA_TO_LOWER (p_buf);
     }
 }
@@ -296,6 +326,15 @@ void  btm_route_sco_data(BT_HDR *p_msg)
 
     if ((sco_inx = btm_find_scb_by_handle(handle)) != BTM_MAX_SCO_LINKS )
     {
+        tSCO_CONN *p_ccb = &btm_cb.sco_cb.sco_db[sco_inx];
+
+        /* the controller consumes one packet per received packet, return the credit */
+        p_ccb->rcv_pkts++;
+        if (pkt_status != BTM_SCO_DATA_CORRECT)
+            p_ccb->rcv_errs++;
+        if (p_ccb->xmit_credits < btm_sco_max_xmit_credits())
+            p_ccb->xmit_credits++;
+
         /* send data callback */
         if (!btm_cb.sco_cb.p_data_cb )
             /* if no data callback registered,  just free the buffer  */
@@ -304,6 +343,8 @@ void  btm_route_sco_data(BT_HDR *p_msg)
         {
             (*btm_cb.sco_cb.p_data_cb)(sco_inx, p_msg, (tBTM_SCO_DATA_FLAG) pkt_status);
         }
+
+        btm_sco_check_send_pkts (sco_inx);
     }
     else /* no mapping handle SCO connection is active, free the buffer */
     {
@@ -373,6 +414,14 @@ tBTM_STATUS BTM_WriteScoData (UINT16 sco_inx, BT_HDR *p_buf)
 
             GKI_enqueue (&p_ccb->xmit_data_q, p_buf);
 
+            /* the source runs ahead of the air interface, drop the oldest
+               audio rather than let the latency grow */
+            while (p_ccb->xmit_data_q.count > BTM_SCO_MAX_BUF_CAP)
+            {
+                GKI_freebuf (GKI_dequeue (&p_ccb->xmit_data_q));
+                p_ccb->xmit_drops++;
+            }
+
             btm_sco_check_send_pkts (sco_inx);
         }
     }
@@ -988,6 +1037,9 @@ void btm_sco_connected (UINT8 hci_status, BD_ADDR bda, UINT16 hci_handle,
 
             p->state = SCO_ST_CONNECTED;
             p->hci_handle = hci_handle;
+#if BTM_SCO_HCI_INCLUDED == TRUE
+            p->xmit_credits = btm_sco_max_xmit_credits();
+#endif
 
             if (!btm_cb.sco_cb.esco_supported)
             {
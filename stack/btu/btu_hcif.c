@@ -1652,6 +1652,9 @@ void btu_hcif_cmd_timeout (UINT8 controller_id)
 #endif
 // btla-specific ++
 
+    /* write out the traces leading up to the timeout in recorder mode */
+    bte_log_dump();
+
     /* send stack a fake command complete or command status, but first determine
     ** which to send
     */
@@ -1735,6 +1738,9 @@ static void btu_hcif_hardware_error_evt (UINT8 *p)
 {
     HCI_TRACE_ERROR("Ctlr H/w error event - code:0x%x", *p);
 
+    /* write out the traces leading up to the error in recorder mode */
+    bte_log_dump();
+
     /* If anyone wants device status notifications, give him one. */
     btm_report_device_status (BTM_DEV_STATUS_DOWN);
 
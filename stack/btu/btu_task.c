@@ -149,6 +149,31 @@ tBTU_CB  btu_cb;
 /* Define a function prototype to allow a generic timeout handler */
 typedef void (tUSER_TIMEOUT_FUNC) (TIMER_LIST_ENT *p_tle);
 
+/*******************************************************************************
+**
+** Function         btu_read_hci_batch
+**
+** Description      Returns the next message of the HCI mailbox. The mailbox is
+**                  detached a batch at a time; between batches L2CAP sends
+**                  what the completed packets of the last batch allow.
+**
+** Returns          the message, or NULL when the mailbox is empty
+**
+*******************************************************************************/
+static BT_HDR *btu_read_hci_batch (void **pp_batch)
+{
+    if (*pp_batch == NULL)
+    {
+        if ((*pp_batch = GKI_read_mbox_all (BTU_HCI_RCV_MBOX)) == NULL)
+            return (NULL);
+
+        l2c_link_defer_send_check (FALSE);
+        l2c_link_defer_send_check (TRUE);
+    }
+
+    return ((BT_HDR *) GKI_read_batch (pp_batch));
+}
+
 /*******************************************************************************
 **
 ** Function         btu_task
@@ -167,6 +192,7 @@ BTU_API UINT32 btu_task (UINT32 param)
     UINT8            i;
     UINT16           mask;
     BOOLEAN          handled;
+    void            *p_batch;
     UNUSED(param);
 
 #if (defined(HCISU_H4_INCLUDED) && HCISU_H4_INCLUDED == TRUE)
@@ -233,8 +259,10 @@ BTU_API UINT32 btu_task (UINT32 param)
 
         if (event & TASK_MBOX_0_EVT_MASK)
         {
-            /* Process all messages in the queue */
-            while ((p_msg = (BT_HDR *) GKI_read_mbox (BTU_HCI_RCV_MBOX)) != NULL)
+            /* Process all messages in the queue, a batch per mailbox lock */
+            p_batch = NULL;
+            l2c_link_defer_send_check (TRUE);
+            while ((p_msg = btu_read_hci_batch (&p_batch)) != NULL)
             {
                 /* Determine the input message type. */
                 switch (p_msg->event & BT_EVT_MASK)
@@ -393,6 +421,7 @@ BTU_API UINT32 btu_task (UINT32 param)
                         break;
                 }
             }
+            l2c_link_defer_send_check (FALSE);
         }
 
 
@@ -1349,6 +1349,10 @@ typedef struct
 #define HCI_BRCM_ACL_PRIORITY_HIGH          0xFF
 #define HCI_BRCM_SET_ACL_PRIORITY           (0x0057 | HCI_GRP_VENDOR_SPECIFIC)
 
+/* SCO routing parameter for the Broadcom SCO PCM configuration VSC */
+#define HCI_BRCM_SCO_ROUTE_PCM              0x00
+#define HCI_BRCM_SCO_ROUTE_HCI              0x01
+
 /* Define values for LMP Test Control parameters
 ** Test Scenario, Hopping Mode, Power Control Mode
 */
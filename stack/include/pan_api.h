@@ -331,8 +331,8 @@ PAN_API extern tPAN_RESULT PAN_Disconnect (UINT16 handle);
 **                  on GN or NAP side and the packet is multicast or broadcast
 **                  it will be sent on all the links. Otherwise the correct link
 **                  is found based on the destination address and forwarded on it
-**                  If the return value is not PAN_SUCCESS the application should
-**                  take care of releasing the message buffer
+**                  If the return value is PAN_Q_SIZE_EXCEEDED the message buffer
+**                  is not released, the application may retry or free it
 **
 ** Parameters:      dst      - MAC or BD Addr of the destination device
 **                  src      - MAC or BD Addr of the source who sent this packet
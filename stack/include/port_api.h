@@ -101,6 +101,19 @@ typedef int  (tPORT_DATA_CALLBACK) (UINT16 port_handle, void *p_data, UINT16 len
 #define DATA_CO_CALLBACK_TYPE_INCOMING          1
 #define DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE     2
 #define DATA_CO_CALLBACK_TYPE_OUTGOING          3
+#define DATA_CO_CALLBACK_TYPE_OUTGOING_BATCH    4
+
+/*
+** One buffer of a batched outgoing call-out. For DATA_CO_CALLBACK_TYPE_OUTGOING_BATCH
+** p_buf points to an array of these and len is the number of entries. Every
+** entry must be filled completely for the call-out to succeed.
+*/
+typedef struct
+{
+    UINT8   *p_data;
+    UINT16  len;
+} tPORT_DATA_CO_SEG;
+
 typedef int  (tPORT_DATA_CO_CALLBACK) (UINT16 port_handle, UINT8* p_buf, UINT16 len, int type);
 
 typedef void (tPORT_CALLBACK) (UINT32 code, UINT16 port_handle);
@@ -407,6 +407,8 @@ typedef struct t_l2c_linkcb
 
     BOOLEAN             partial_segment_being_sent; /* Set TRUE when a partial segment  */
                                                     /* is being sent.                   */
+    BOOLEAN             send_check_pending;         /* Controller buffers freed during  */
+                                                    /* a deferred btu batch             */
     BOOLEAN             w4_info_rsp;                /* TRUE when info request is active */
     UINT8               info_rx_bits;               /* set 1 if received info type */
     UINT32              peer_ext_fea;               /* Peer's extended features mask    */
@@ -472,6 +474,7 @@ typedef struct
     BOOLEAN         check_round_robin;              /* Do a round robin check           */
 
     BOOLEAN         is_cong_cback_context;
+    BOOLEAN         defer_send_check;               /* btu is draining a batch of HCI msgs */
 
     tL2C_LCB        lcb_pool[MAX_L2CAP_LINKS];      /* Link Control Block pool          */
     tL2C_CCB        ccb_pool[MAX_L2CAP_CHANNELS];   /* Channel Control Block pool       */
@@ -709,6 +712,7 @@ extern UINT8    l2c_link_pkts_rcvd (UINT16 *num_pkts, UINT16 *handles);
 extern void     l2c_link_role_changed (BD_ADDR bd_addr, UINT8 new_role, UINT8 hci_status);
 extern void     l2c_link_sec_comp (BD_ADDR p_bda, tBT_TRANSPORT trasnport, void *p_ref_data, UINT8 status);
 extern void     l2c_link_segments_xmitted (BT_HDR *p_msg);
+extern void     l2c_link_defer_send_check (BOOLEAN defer);
 extern void     l2c_pin_code_request (BD_ADDR bd_addr);
 extern void     l2c_link_adjust_chnl_allocation (void);
 
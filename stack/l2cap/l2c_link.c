@@ -40,6 +40,8 @@
 #include "btm_int.h"
 
 static BOOLEAN l2c_link_send_to_lower (tL2C_LCB *p_lcb, BT_HDR *p_buf);
+static void l2c_link_check_send_hi_pri (tL2C_LCB *p_skip_lcb);
+static void l2c_link_send_completed (tL2C_LCB *p_lcb);
 
 #define L2C_LINK_SEND_ACL_DATA(x)  HCI_ACL_DATA_TO_LOWER((x))
 
@@ -1324,6 +1326,47 @@ void l2c_link_check_send_pkts (tL2C_LCB *p_lcb, tL2C_CCB *p_ccb, BT_HDR *p_buf)
 
 }
 
+/*******************************************************************************
+**
+** Function         l2c_link_check_send_hi_pri
+**
+** Description      This function gives every high priority link that is below
+**                  its transmit quota a chance to send. It is used when
+**                  controller buffers are released by another link, which
+**                  otherwise would be the only link serviced.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2c_link_check_send_hi_pri (tL2C_LCB *p_skip_lcb)
+{
+    tL2C_LCB    *p_lcb;
+    int         xx;
+
+    for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS; xx++, p_lcb++)
+    {
+        if ( (p_lcb == p_skip_lcb)
+          || (!p_lcb->in_use)
+          || (p_lcb->acl_priority != L2CAP_PRIORITY_HIGH)
+          || (p_lcb->link_state != LST_CONNECTED)
+          || (p_lcb->sent_not_acked >= p_lcb->link_xmit_quota) )
+            continue;
+
+#if (BLE_INCLUDED == TRUE)
+        if (p_lcb->transport == BT_TRANSPORT_LE)
+        {
+            if (l2cb.controller_le_xmit_window == 0)
+                continue;
+        }
+        else
+#endif
+        if (l2cb.controller_xmit_window == 0)
+            continue;
+
+        l2c_link_check_send_pkts (p_lcb, NULL, NULL);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         l2c_link_send_to_lower
@@ -1466,6 +1509,76 @@ static BOOLEAN l2c_link_send_to_lower (tL2C_LCB *p_lcb, BT_HDR *p_buf)
     return TRUE;
 }
 
+/*******************************************************************************
+**
+** Function         l2c_link_send_completed
+**
+** Description      This function sends what the controller buffers freed by
+**                  completed packets of a link allow.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2c_link_send_completed (tL2C_LCB *p_lcb)
+{
+    /* Controller buffers freed by a low priority link go to waiting high
+    ** priority (e.g. media) links first, so they are not held up until
+    ** one of their own packets completes. */
+    if (p_lcb->acl_priority != L2CAP_PRIORITY_HIGH)
+        l2c_link_check_send_hi_pri (p_lcb);
+
+    l2c_link_check_send_pkts (p_lcb, NULL, NULL);
+
+    /* If we were doing round-robin for low priority links, check 'em */
+    if ( (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
+      && (l2cb.check_round_robin)
+      && (l2cb.round_robin_unacked < l2cb.round_robin_quota) )
+    {
+      l2c_link_check_send_pkts (NULL, NULL, NULL);
+    }
+#if BLE_INCLUDED == TRUE
+    if ((p_lcb->transport == BT_TRANSPORT_LE)
+        && (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
+        && ((l2cb.ble_check_round_robin)
+        && (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota)))
+    {
+      l2c_link_check_send_pkts (NULL, NULL, NULL);
+    }
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         l2c_link_defer_send_check
+**
+** Description      This function is called by btu around a batch of HCI
+**                  messages. While deferred, completed packets and segments
+**                  only mark their link, and the links are serviced once when
+**                  the deferral ends, instead of once per event.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2c_link_defer_send_check (BOOLEAN defer)
+{
+    tL2C_LCB    *p_lcb;
+    int         xx;
+
+    l2cb.defer_send_check = defer;
+    if (defer)
+        return;
+
+    for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS; xx++, p_lcb++)
+    {
+        if (p_lcb->send_check_pending)
+        {
+            p_lcb->send_check_pending = FALSE;
+            if (p_lcb->in_use)
+                l2c_link_send_completed (p_lcb);
+        }
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         l2c_link_process_num_completed_pkts
@@ -1541,24 +1654,11 @@ void l2c_link_process_num_completed_pkts (UINT8 *p)
             else
                 p_lcb->sent_not_acked = 0;
 
-            l2c_link_check_send_pkts (p_lcb, NULL, NULL);
-
-            /* If we were doing round-robin for low priority links, check 'em */
-            if ( (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
-              && (l2cb.check_round_robin)
-              && (l2cb.round_robin_unacked < l2cb.round_robin_quota) )
-            {
-              l2c_link_check_send_pkts (NULL, NULL, NULL);
-            }
-#if BLE_INCLUDED == TRUE
-            if ((p_lcb->transport == BT_TRANSPORT_LE)
-                && (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
-                && ((l2cb.ble_check_round_robin)
-                && (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota)))
-            {
-              l2c_link_check_send_pkts (NULL, NULL, NULL);
-            }
-#endif
+            /* While btu drains a batch, send once per link at its end */
+            if (l2cb.defer_send_check)
+                p_lcb->send_check_pending = TRUE;
+            else
+                l2c_link_send_completed (p_lcb);
         }
 
 #if (L2CAP_HCI_FLOW_CONTROL_DEBUG == TRUE)
@@ -1824,7 +1924,10 @@ void l2c_link_segments_xmitted (BT_HDR *p_msg)
 
         p_lcb->partial_segment_being_sent = FALSE;
 
-        l2c_link_check_send_pkts (p_lcb, NULL, NULL);
+        if (l2cb.defer_send_check)
+            p_lcb->send_check_pending = TRUE;
+        else
+            l2c_link_check_send_pkts (p_lcb, NULL, NULL);
     }
     else
         GKI_freebuf (p_msg);
@@ -553,6 +553,7 @@ tPAN_RESULT PAN_Disconnect (UINT16 handle)
 tPAN_RESULT PAN_Write(UINT16 handle, BD_ADDR dst, BD_ADDR src, UINT16 protocol, UINT8 *p_data, UINT16 len, BOOLEAN ext)
 {
     BT_HDR *buffer;
+    tPAN_RESULT result;
 
     if (pan_cb.role == PAN_ROLE_INACTIVE || !pan_cb.num_conns) {
         PAN_TRACE_ERROR("%s PAN is not active, data write failed.", __func__);
@@ -582,7 +583,10 @@ tPAN_RESULT PAN_Write(UINT16 handle, BD_ADDR dst, BD_ADDR src, UINT16 protocol,
     buffer->offset = PAN_MINIMUM_OFFSET;
     memcpy((UINT8 *)buffer + sizeof(BT_HDR) + buffer->offset, p_data, buffer->len);
 
-    return PAN_WriteBuf(handle, dst, src, protocol, buffer, ext);
+    result = PAN_WriteBuf(handle, dst, src, protocol, buffer, ext);
+    if (result == PAN_Q_SIZE_EXCEEDED)
+        GKI_freebuf(buffer);
+    return result;
 }
 
 
@@ -594,8 +598,8 @@ tPAN_RESULT PAN_Write(UINT16 handle, BD_ADDR dst, BD_ADDR src, UINT16 protocol,
 **                  on GN or NAP side and the packet is multicast or broadcast
 **                  it will be sent on all the links. Otherwise the correct link
 **                  is found based on the destination address and forwarded on it
-**                  If the return value is not PAN_SUCCESS the application should
-**                  take care of releasing the message buffer
+**                  If the return value is PAN_Q_SIZE_EXCEEDED the message buffer
+**                  is not released, the application may retry or free it
 **
 ** Parameters:      handle   - handle for the connection
 **                  dst      - MAC or BD Addr of the destination device
@@ -37,6 +37,11 @@
 /* duration of break in 200ms units */
 #define PORT_BREAK_DURATION     1
 
+/* max number of buffers filled by one call-out read in PORT_WriteDataCO */
+#ifndef PORT_CO_MAX_BATCH
+#define PORT_CO_MAX_BATCH       PORT_TX_BUF_HIGH_WM
+#endif
+
 #include <cutils/log.h>
 #define info(fmt, ...)  ALOGI ("%s: " fmt,__FUNCTION__,  ## __VA_ARGS__)
 #define debug(fmt, ...) ALOGD ("%s: " fmt,__FUNCTION__,  ## __VA_ARGS__)
@@ -1552,63 +1557,92 @@ int PORT_WriteDataCO (UINT16 handle, int* p_len)
 
     PORT_SCHEDULE_UNLOCK;
 
-    //int max_read = length < p_port->peer_mtu ? length : p_port->peer_mtu;
-
-    //max_read = available < max_read ? available : max_read;
+    if (p_port->peer_mtu < length)
+        length = p_port->peer_mtu;
 
     while (available)
     {
-        /* if we're over buffer high water mark, we're done */
-        if ((p_port->tx.queue_size  > PORT_TX_HIGH_WM)
-         || (p_port->tx.queue.count > PORT_TX_BUF_HIGH_WM))
+        BT_HDR            *p_bufs[PORT_CO_MAX_BATCH];
+        tPORT_DATA_CO_SEG segs[PORT_CO_MAX_BATCH];
+        UINT16            num_bufs = 0;
+        UINT16            i;
+        int               batch_len = 0;
+
+        /* Carve as many frames as the tx queue still takes out of one read */
+        while ((num_bufs < PORT_CO_MAX_BATCH) && (batch_len < available))
         {
-            port_flow_control_user(p_port);
-            event |= PORT_EV_FC;
-            debug("tx queue is full,tx.queue_size:%d,tx.queue.count:%d,available:%d",
-                    p_port->tx.queue_size, p_port->tx.queue.count, available);
-            break;
-         }
+            /* if we're over buffer high water mark, we're done */
+            if ((p_port->tx.queue_size + batch_len > PORT_TX_HIGH_WM)
+             || (p_port->tx.queue.count + num_bufs > PORT_TX_BUF_HIGH_WM))
+                break;
+
+            if ((p_buf = (BT_HDR *)GKI_getpoolbuf (RFCOMM_DATA_POOL_ID)) == NULL)
+                break;
+
+            p_buf->offset         = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+            p_buf->layer_specific = handle;
+            p_buf->len            = length;
+            if (available - batch_len < (int)length)
+                p_buf->len = (UINT16)(available - batch_len);
+            p_buf->event          = BT_EVT_TO_BTU_SP_DATA;
+
+            segs[num_bufs].p_data = (UINT8 *)(p_buf + 1) + p_buf->offset;
+            segs[num_bufs].len    = p_buf->len;
+            p_bufs[num_bufs++]    = p_buf;
+            batch_len += p_buf->len;
+        }
 
-        /* continue with rfcomm data write */
-        p_buf = (BT_HDR *)GKI_getpoolbuf (RFCOMM_DATA_POOL_ID);
-        if (!p_buf)
+        if (num_bufs == 0)
+        {
+            if ((p_port->tx.queue_size  > PORT_TX_HIGH_WM)
+             || (p_port->tx.queue.count > PORT_TX_BUF_HIGH_WM))
+            {
+                port_flow_control_user(p_port);
+                event |= PORT_EV_FC;
+                debug("tx queue is full,tx.queue_size:%d,tx.queue.count:%d,available:%d",
+                        p_port->tx.queue_size, p_port->tx.queue.count, available);
+            }
             break;
+        }
 
-        p_buf->offset         = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-        p_buf->layer_specific = handle;
-
-        if (p_port->peer_mtu < length)
-            length = p_port->peer_mtu;
-        if (available < (int)length)
-            length = (UINT16)available;
-        p_buf->len = length;
-        p_buf->event          = BT_EVT_TO_BTU_SP_DATA;
-
-        //memcpy ((UINT8 *)(p_buf + 1) + p_buf->offset, p_data, length);
-        //if(recv(fd, (UINT8 *)(p_buf + 1) + p_buf->offset, (int)length, 0) != (int)length)
-        if(p_port->p_data_co_callback(handle, (UINT8 *)(p_buf + 1) + p_buf->offset, length,
-                                      DATA_CO_CALLBACK_TYPE_OUTGOING) == FALSE)
+        if(p_port->p_data_co_callback(handle, (UINT8 *)segs, num_bufs,
+                                      DATA_CO_CALLBACK_TYPE_OUTGOING_BATCH) == FALSE)
         {
-            error("p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d", length);
+            error("p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING_BATCH failed, bufs:%d, length:%d",
+                    num_bufs, batch_len);
+            for (i = 0; i < num_bufs; i++)
+                GKI_freebuf (p_bufs[i]);
             return (PORT_UNKNOWN_ERROR);
         }
 
+        RFCOMM_TRACE_EVENT ("PORT_WriteData %d bytes in %d buffers", batch_len, num_bufs);
 
-        RFCOMM_TRACE_EVENT ("PORT_WriteData %d bytes", length);
+        for (i = 0; i < num_bufs; i++)
+        {
+            length = p_bufs[i]->len;
+            rc = port_write (p_port, p_bufs[i]);
 
-        rc = port_write (p_port, p_buf);
+            /* If queue went below the threashold need to send flow control */
+            event |= port_flow_control_user (p_port);
 
-        /* If queue went below the threashold need to send flow control */
-        event |= port_flow_control_user (p_port);
+            if (rc == PORT_SUCCESS)
+                event |= PORT_EV_TXCHAR;
 
-        if (rc == PORT_SUCCESS)
-            event |= PORT_EV_TXCHAR;
+            if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING))
+                break;
 
-        if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING))
-            break;
+            *p_len  += length;
+            available -= (int)length;
+        }
 
-        *p_len  += length;
-        available -= (int)length;
+        /* The data was already read from the socket, drop what could not be queued */
+        if (i < num_bufs)
+        {
+            RFCOMM_TRACE_WARNING ("PORT_WriteDataCO dropped %d buffers, rc:%d", num_bufs - i - 1, rc);
+            while (++i < num_bufs)
+                GKI_freebuf (p_bufs[i]);
+            break;
+        }
     }
     if (!available && (rc != PORT_CMD_PENDING) && (rc != PORT_TX_QUEUE_DISABLED))
         event |= PORT_EV_TXEMPTY;
@@ -44,8 +44,147 @@
 /********************************************************************************/
 static BOOLEAN find_uuid_in_seq (UINT8 *p , UINT32 seq_len, UINT8 *p_his_uuid,
                                  UINT16 his_len, int nest_level);
+static BOOLEAN sdp_db_index_uuids_in_seq (tSDP_RECORD *p_rec, UINT8 *p, UINT32 seq_len,
+                                          int nest_level);
 
 
+/*******************************************************************************
+**
+** Function         sdp_db_build_uuid_index
+**
+** Description      This function collects the location of every UUID in a
+**                  record, including UUIDs nested in data element sequences,
+**                  so searches do not have to parse the attributes again.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_db_build_uuid_index (tSDP_RECORD *p_rec)
+{
+    tSDP_ATTRIBUTE *p_attr = &p_rec->attribute[0];
+    UINT16          xx;
+
+    p_rec->num_uuids = 0;
+
+    for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
+    {
+        if (p_attr->type == UUID_DESC_TYPE)
+        {
+            if (p_rec->num_uuids == SDP_MAX_REC_UUIDS)
+                break;
+            p_rec->uuid_index[p_rec->num_uuids].offset = (UINT16)(p_attr->value_ptr - p_rec->attr_pad);
+            p_rec->uuid_index[p_rec->num_uuids].len    = (UINT8)p_attr->len;
+            p_rec->num_uuids++;
+        }
+        else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
+        {
+            if (!sdp_db_index_uuids_in_seq (p_rec, p_attr->value_ptr, p_attr->len, 0))
+                break;
+        }
+    }
+
+    if (xx < p_rec->num_attributes)
+    {
+        SDP_TRACE_WARNING("sdp_db_build_uuid_index: handle 0x%x has more than %d UUIDs",
+                          p_rec->record_handle, SDP_MAX_REC_UUIDS);
+        p_rec->num_uuids = SDP_UUID_INDEX_OFLOW;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_index_uuids_in_seq
+**
+** Description      This function adds the UUIDs of a data element sequence to
+**                  the UUID index of a record. The same nesting limit as
+**                  find_uuid_in_seq applies.
+**
+** Returns          FALSE if the index is full, else TRUE
+**
+*******************************************************************************/
+static BOOLEAN sdp_db_index_uuids_in_seq (tSDP_RECORD *p_rec, UINT8 *p, UINT32 seq_len,
+                                          int nest_level)
+{
+    UINT8   *p_end = p + seq_len;
+    UINT8   type;
+    UINT32  len;
+
+    if (nest_level > 3)
+        return (TRUE);
+
+    while (p < p_end)
+    {
+        type = *p++;
+        p = sdpu_get_len_from_type (p, type, &len);
+        type = type >> 3;
+        if (type == UUID_DESC_TYPE)
+        {
+            if (p_rec->num_uuids == SDP_MAX_REC_UUIDS)
+                return (FALSE);
+            p_rec->uuid_index[p_rec->num_uuids].offset = (UINT16)(p - p_rec->attr_pad);
+            p_rec->uuid_index[p_rec->num_uuids].len    = (UINT8)len;
+            p_rec->num_uuids++;
+        }
+        else if (type == DATA_ELE_SEQ_DESC_TYPE)
+        {
+            if (!sdp_db_index_uuids_in_seq (p_rec, p, len, nest_level + 1))
+                return (FALSE);
+        }
+        p = p + len;
+    }
+
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_rec_has_uuid
+**
+** Description      This function checks whether a record contains a UUID,
+**                  using the record's UUID index when possible.
+**
+** Returns          TRUE if found, else FALSE
+**
+*******************************************************************************/
+static BOOLEAN sdp_db_rec_has_uuid (tSDP_RECORD *p_rec, tUID_ENT *p_uuid)
+{
+    tSDP_ATTRIBUTE *p_attr;
+    UINT16          xx;
+
+    if (p_rec->num_uuids == SDP_UUID_INDEX_STALE)
+        sdp_db_build_uuid_index (p_rec);
+
+    if (p_rec->num_uuids != SDP_UUID_INDEX_OFLOW)
+    {
+        for (xx = 0; xx < p_rec->num_uuids; xx++)
+        {
+            if (sdpu_compare_uuid_arrays (&p_rec->attr_pad[p_rec->uuid_index[xx].offset],
+                                          p_rec->uuid_index[xx].len,
+                                          &p_uuid->value[0], p_uuid->len))
+                return (TRUE);
+        }
+        return (FALSE);
+    }
+
+    p_attr = &p_rec->attribute[0];
+    for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
+    {
+        if (p_attr->type == UUID_DESC_TYPE)
+        {
+            if (sdpu_compare_uuid_arrays (p_attr->value_ptr, p_attr->len,
+                                          &p_uuid->value[0], p_uuid->len))
+                return (TRUE);
+        }
+        else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
+        {
+            if (find_uuid_in_seq (p_attr->value_ptr, p_attr->len,
+                                  &p_uuid->value[0], p_uuid->len, 0))
+                return (TRUE);
+        }
+    }
+    return (FALSE);
+}
+
 /*******************************************************************************
 **
 ** Function         sdp_db_service_search
@@ -59,8 +198,7 @@ static BOOLEAN find_uuid_in_seq (UINT8 *p , UINT32 seq_len, UINT8 *p_his_uuid,
 *******************************************************************************/
 tSDP_RECORD *sdp_db_service_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq)
 {
-    UINT16          xx, yy;
-    tSDP_ATTRIBUTE *p_attr;
+    UINT16          yy;
     tSDP_RECORD     *p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
 
     /* If NULL, start at the beginning, else start at the first specified record */
@@ -75,26 +213,8 @@ tSDP_RECORD *sdp_db_service_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq)
     {
         for (yy = 0; yy < p_seq->num_uids; yy++)
         {
-            p_attr = &p_rec->attribute[0];
-            for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
-            {
-                if (p_attr->type == UUID_DESC_TYPE)
-                {
-                    if (sdpu_compare_uuid_arrays (p_attr->value_ptr, p_attr->len,
-                                                  &p_seq->uuid_entry[yy].value[0],
-                                                  p_seq->uuid_entry[yy].len))
-                        break;
-                }
-                else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
-                {
-                    if (find_uuid_in_seq (p_attr->value_ptr, p_attr->len,
-                                          &p_seq->uuid_entry[yy].value[0],
-                                          p_seq->uuid_entry[yy].len, 0))
-                        break;
-                }
-            }
             /* If any UUID was not found,  on to the next record */
-            if (xx == p_rec->num_attributes)
+            if (!sdp_db_rec_has_uuid (p_rec, &p_seq->uuid_entry[yy]))
                 break;
         }
 
@@ -190,17 +310,22 @@ tSDP_RECORD *sdp_db_find_record (UINT32 handle)
 tSDP_ATTRIBUTE *sdp_db_find_attr_in_rec (tSDP_RECORD *p_rec, UINT16 start_attr,
                                          UINT16 end_attr)
 {
-    tSDP_ATTRIBUTE  *p_at;
-    UINT16          xx;
+    UINT16          lo = 0, hi = p_rec->num_attributes, mid;
 
-    /* Note that the attributes in a record are assumed to be in sorted order */
-    for (xx = 0, p_at = &p_rec->attribute[0]; xx < p_rec->num_attributes;
-         xx++, p_at++)
+    /* The attributes in a record are kept in sorted order (see SDP_AddAttribute),
+    ** so binary search for the first attribute with an id of at least start_attr */
+    while (lo < hi)
     {
-        if ((p_at->id >= start_attr) && (p_at->id <= end_attr))
-            return (p_at);
+        mid = lo + ((hi - lo) >> 1);
+        if (p_rec->attribute[mid].id < start_attr)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
 
+    if ((lo < p_rec->num_attributes) && (p_rec->attribute[lo].id <= end_attr))
+        return (&p_rec->attribute[lo]);
+
     /* No matching attribute found */
     return (NULL);
 }
@@ -289,6 +414,7 @@ UINT32 SDP_CreateRecord (void)
     {
         memset (&p_db->record[p_db->num_records], 0,
                 sizeof (tSDP_RECORD));
+        p_db->record[p_db->num_records].num_uuids = SDP_UUID_INDEX_STALE;
 
         /* We will use a handle of the first unreserved handle plus last record
         ** number + 1 */
@@ -505,6 +631,7 @@ BOOLEAN SDP_AddAttribute (UINT32 handle, UINT16 attr_id, UINT8 attr_type,
                 return (FALSE);
             }
             p_rec->num_attributes++;
+            p_rec->num_uuids = SDP_UUID_INDEX_STALE;
 
             /*** Mark DI record as used by Broadcom ***/
             if (handle == sdp_cb.server_db.di_primary_handle &&
@@ -943,6 +1070,7 @@ BOOLEAN SDP_DeleteAttribute (UINT32 handle, UINT16 attr_id)
                             *pad_ptr = *(pad_ptr+len);
                         p_rec->free_pad_ptr -= len;
                     }
+                    p_rec->num_uuids = SDP_UUID_INDEX_STALE;
                     return (TRUE);
                 }
             }
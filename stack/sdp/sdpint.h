@@ -80,6 +80,11 @@
 #define     MAX_UUIDS_PER_SEQ       16
 #define     MAX_ATTR_PER_SEQ        16
 
+/* Max number of UUIDs (including those nested in sequences) indexed per record */
+#define     SDP_MAX_REC_UUIDS       24
+#define     SDP_UUID_INDEX_STALE    0xFF    /* index must be rebuilt before use */
+#define     SDP_UUID_INDEX_OFLOW    0xFE    /* too many UUIDs, record is searched in full */
+
 /* Max length we support for any attribute */
 // btla-specific ++
 #ifdef SDP_MAX_ATTR_LEN
@@ -126,6 +131,14 @@ typedef struct
     UINT8   type;
 } tSDP_ATTRIBUTE;
 
+/* Location of a UUID inside the attribute pad of a record. Offsets rather
+** than pointers are used so the index survives records being moved. */
+typedef struct
+{
+    UINT16  offset;
+    UINT8   len;
+} tSDP_UUID_INDEX;
+
 /* An SDP record consists of a handle, and 1 or more attributes */
 typedef struct
 {
@@ -134,6 +147,8 @@ typedef struct
     UINT16              num_attributes;
     tSDP_ATTRIBUTE      attribute[SDP_MAX_REC_ATTR];
     UINT8               attr_pad[SDP_MAX_PAD_LEN];
+    UINT8               num_uuids;      /* entries in uuid_index, or SDP_UUID_INDEX_xxx */
+    tSDP_UUID_INDEX     uuid_index[SDP_MAX_REC_UUIDS];
 } tSDP_RECORD;
 
 
@@ -37,7 +37,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <pthread.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/poll.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -67,7 +67,12 @@
 #define UIPC_LOCK() /*BTIF_TRACE_EVENT(" %s lock", __FUNCTION__);*/ pthread_mutex_lock(&uipc_main.mutex);
 #define UIPC_UNLOCK() /*BTIF_TRACE_EVENT("%s unlock", __FUNCTION__);*/ pthread_mutex_unlock(&uipc_main.mutex);
 
-#define SAFE_FD_ISSET(fd, set) (((fd) == -1) ? FALSE : FD_ISSET((fd), (set)))
+/* epoll user data tags, the low bits carry the channel id */
+#define UIPC_EP_SIGNAL      0x100
+#define UIPC_EP_SRV         0x200
+#define UIPC_EP_CH_MASK     0x0FF
+
+#define UIPC_MAX_EPOLL_EVENTS (UIPC_CH_NUM * 2 + 1)
 
 /*****************************************************************************
 **  Local type definitions
@@ -93,9 +98,7 @@ typedef struct {
     int running;
     pthread_mutex_t mutex;
 
-    fd_set active_set;
-    fd_set read_set;
-    int max_fd;
+    int epfd;
     int signal_fds[2];
 
     tUIPC_CHAN ch[UIPC_CH_NUM];
@@ -114,6 +117,8 @@ static tUIPC_MAIN uipc_main;
 ******************************************************************************/
 
 static int uipc_close_ch_locked(tUIPC_CH_ID ch_id);
+static void uipc_add_fd_locked(int fd, UINT32 tag);
+static void uipc_del_fd_locked(int fd);
 
 /*****************************************************************************
 **  Externs
@@ -213,14 +218,20 @@ static int uipc_main_init(void)
 
     BTIF_TRACE_EVENT("### uipc_main_init ###");
 
+    uipc_main.epfd = epoll_create(UIPC_MAX_EPOLL_EVENTS);
+    if (uipc_main.epfd < 0)
+    {
+        BTIF_TRACE_ERROR("epoll_create failed (%s)", strerror(errno));
+        return -1;
+    }
+
     /* setup interrupt socket pair */
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc_main.signal_fds) < 0)
     {
         return -1;
     }
 
-    FD_SET(uipc_main.signal_fds[0], &uipc_main.active_set);
-    uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.signal_fds[0]);
+    uipc_add_fd_locked(uipc_main.signal_fds[0], UIPC_EP_SIGNAL);
 
     for (i=0; i< UIPC_CH_NUM; i++)
     {
@@ -248,6 +259,30 @@ void uipc_main_cleanup(void)
     /* close any open channels */
     for (i=0; i<UIPC_CH_NUM; i++)
         uipc_close_ch_locked(i);
+
+    close(uipc_main.epfd);
+    uipc_main.epfd = -1;
+}
+
+static void uipc_add_fd_locked(int fd, UINT32 tag)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = tag;
+
+    if (epoll_ctl(uipc_main.epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        BTIF_TRACE_ERROR("failed to add fd %d to epoll set (%s)", fd, strerror(errno));
+}
+
+static void uipc_del_fd_locked(int fd)
+{
+    struct epoll_event ev;
+
+    /* fd may already be gone from the set, that's fine */
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(uipc_main.epfd, EPOLL_CTL_DEL, fd, &ev);
 }
 
 
@@ -272,14 +307,14 @@ static void uipc_check_task_flags_locked(void)
 }
 
 
-static int uipc_check_fd_locked(tUIPC_CH_ID ch_id)
+static int uipc_check_fd_locked(tUIPC_CH_ID ch_id, UINT32 ready)
 {
     if (ch_id >= UIPC_CH_NUM)
         return -1;
 
     //BTIF_TRACE_EVENT("CHECK SRVFD %d (ch %d)", uipc_main.ch[ch_id].srvfd, ch_id);
 
-    if (SAFE_FD_ISSET(uipc_main.ch[ch_id].srvfd, &uipc_main.read_set))
+    if ((ready & UIPC_EP_SRV) && (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED))
     {
         BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
 
@@ -292,8 +327,7 @@ static int uipc_check_fd_locked(tUIPC_CH_ID ch_id)
             /*  if we have a callback we should add this fd to the active set
                 and notify user with callback event */
             BTIF_TRACE_EVENT("ADD FD %d TO ACTIVE SET", uipc_main.ch[ch_id].fd);
-            FD_SET(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-            uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.ch[ch_id].fd);
+            uipc_add_fd_locked(uipc_main.ch[ch_id].fd, ch_id);
         }
 
         if (uipc_main.ch[ch_id].fd < 0)
@@ -308,7 +342,7 @@ static int uipc_check_fd_locked(tUIPC_CH_ID ch_id)
 
     //BTIF_TRACE_EVENT("CHECK FD %d (ch %d)", uipc_main.ch[ch_id].fd, ch_id);
 
-    if (SAFE_FD_ISSET(uipc_main.ch[ch_id].fd, &uipc_main.read_set))
+    if ((ready & ~UIPC_EP_SRV) && (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED))
     {
         //BTIF_TRACE_EVENT("INCOMING DATA ON CH %d", ch_id);
 
@@ -320,12 +354,10 @@ static int uipc_check_fd_locked(tUIPC_CH_ID ch_id)
 
 static void uipc_check_interrupt_locked(void)
 {
-    if (SAFE_FD_ISSET(uipc_main.signal_fds[0], &uipc_main.read_set))
-    {
-        char sig_recv = 0;
-        //BTIF_TRACE_EVENT("UIPC INTERRUPT");
-        recv(uipc_main.signal_fds[0], &sig_recv, sizeof(sig_recv), MSG_WAITALL);
-    }
+    char sig_recv[8];
+    //BTIF_TRACE_EVENT("UIPC INTERRUPT");
+    /* drain all pending wakeups in one go */
+    recv(uipc_main.signal_fds[0], sig_recv, sizeof(sig_recv), MSG_DONTWAIT);
 }
 
 static inline void uipc_wakeup_locked(void)
@@ -356,8 +388,7 @@ static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, char *name, tUIPC_RCV_CBA
     }
 
     BTIF_TRACE_EVENT("ADD SERVER FD TO ACTIVE SET %d", fd);
-    FD_SET(fd, &uipc_main.active_set);
-    uipc_main.max_fd = MAX(uipc_main.max_fd, fd);
+    uipc_add_fd_locked(fd, UIPC_EP_SRV | ch_id);
 
     uipc_main.ch[ch_id].srvfd = fd;
     uipc_main.ch[ch_id].cback = cback;
@@ -431,8 +462,8 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id)
     if (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED)
     {
         BTIF_TRACE_EVENT("CLOSE SERVER (FD %d)", uipc_main.ch[ch_id].srvfd);
+        uipc_del_fd_locked(uipc_main.ch[ch_id].srvfd);
         close(uipc_main.ch[ch_id].srvfd);
-        FD_CLR(uipc_main.ch[ch_id].srvfd, &uipc_main.active_set);
         uipc_main.ch[ch_id].srvfd = UIPC_DISCONNECTED;
         wakeup = 1;
     }
@@ -440,8 +471,8 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id)
     if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED)
     {
         BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc_main.ch[ch_id].fd);
+        uipc_del_fd_locked(uipc_main.ch[ch_id].fd);
         close(uipc_main.ch[ch_id].fd);
-        FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
         uipc_main.ch[ch_id].fd = UIPC_DISCONNECTED;
         wakeup = 1;
     }
@@ -474,8 +505,11 @@ void uipc_close_locked(tUIPC_CH_ID ch_id)
 
 static void uipc_read_task(void *arg)
 {
+    struct epoll_event events[UIPC_MAX_EPOLL_EVENTS];
+    UINT32 ready[UIPC_CH_NUM];
     int ch_id;
     int result;
+    int i;
     UNUSED(arg);
 
     prctl(PR_SET_NAME, (unsigned long)"uipc-main", 0, 0, 0);
@@ -484,37 +518,50 @@ static void uipc_read_task(void *arg)
 
     while (uipc_main.running)
     {
-        uipc_main.read_set = uipc_main.active_set;
-
-        result = select(uipc_main.max_fd+1, &uipc_main.read_set, NULL, NULL, NULL);
+        result = epoll_wait(uipc_main.epfd, events, UIPC_MAX_EPOLL_EVENTS, -1);
 
         if (result == 0)
         {
-            BTIF_TRACE_EVENT("select timeout");
+            BTIF_TRACE_EVENT("epoll timeout");
             continue;
         }
         else if (result < 0)
         {
-            BTIF_TRACE_EVENT("select failed %s", strerror(errno));
+            if (errno != EINTR)
+                BTIF_TRACE_EVENT("epoll failed %s", strerror(errno));
             continue;
         }
 
         UIPC_LOCK();
 
-        /* clear any wakeup interrupt */
-        uipc_check_interrupt_locked();
+        /* sort the ready fds per channel, both server and connection fds may be ready */
+        memset(ready, 0, sizeof(ready));
+        for (i = 0; i < result; i++)
+        {
+            if (events[i].data.u32 == UIPC_EP_SIGNAL)
+            {
+                /* clear any wakeup interrupt */
+                uipc_check_interrupt_locked();
+                continue;
+            }
+
+            ch_id = events[i].data.u32 & UIPC_EP_CH_MASK;
+            if (ch_id < UIPC_CH_NUM)
+                ready[ch_id] |= (events[i].data.u32 & UIPC_EP_SRV) ? UIPC_EP_SRV : events[i].events;
+        }
 
         /* check pending task events */
         uipc_check_task_flags_locked();
 
         /* make sure we service audio channel first */
-        uipc_check_fd_locked(UIPC_CH_ID_AV_AUDIO);
+        if (ready[UIPC_CH_ID_AV_AUDIO])
+            uipc_check_fd_locked(UIPC_CH_ID_AV_AUDIO, ready[UIPC_CH_ID_AV_AUDIO]);
 
         /* check for other connections */
         for (ch_id = 0; ch_id < UIPC_CH_NUM; ch_id++)
         {
-            if (ch_id != UIPC_CH_ID_AV_AUDIO)
-                uipc_check_fd_locked(ch_id);
+            if ((ch_id != UIPC_CH_ID_AV_AUDIO) && ready[ch_id])
+                uipc_check_fd_locked(ch_id, ready[ch_id]);
         }
 
         UIPC_UNLOCK();
@@ -761,29 +808,35 @@ UDRV_API UINT32 UIPC_Read(tUIPC_CH_ID ch_id, UINT16 *p_msg_evt, UINT8 *p_buf, UI
 
     while (n_read < (int)len)
     {
-        pfd.fd = fd;
-        pfd.events = POLLIN|POLLHUP;
+        /* take whatever is already queued in one go, only wait when there is nothing */
+        n = recv(fd, p_buf+n_read, len-n_read, MSG_DONTWAIT);
 
-        /* make sure there is data prior to attempting read to avoid blocking
-           a read for more than poll timeout */
-        if (poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms) == 0)
+        if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
         {
-            BTIF_TRACE_EVENT("poll timeout (%d ms)", uipc_main.ch[ch_id].read_poll_tmo_ms);
-            break;
-        }
+            pfd.fd = fd;
+            pfd.events = POLLIN|POLLHUP;
 
-        //BTIF_TRACE_EVENT("poll revents %x", pfd.revents);
+            /* make sure there is data prior to attempting read to avoid blocking
+               a read for more than poll timeout */
+            if (poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms) == 0)
+            {
+                BTIF_TRACE_EVENT("poll timeout (%d ms)", uipc_main.ch[ch_id].read_poll_tmo_ms);
+                break;
+            }
 
-        if (pfd.revents & (POLLHUP|POLLNVAL) )
-        {
-            BTIF_TRACE_EVENT("poll : channel detached remotely");
-            UIPC_LOCK();
-            uipc_close_locked(ch_id);
-            UIPC_UNLOCK();
-            return 0;
-        }
+            //BTIF_TRACE_EVENT("poll revents %x", pfd.revents);
 
-        n = recv(fd, p_buf+n_read, len-n_read, 0);
+            if (pfd.revents & (POLLHUP|POLLNVAL) )
+            {
+                BTIF_TRACE_EVENT("poll : channel detached remotely");
+                UIPC_LOCK();
+                uipc_close_locked(ch_id);
+                UIPC_UNLOCK();
+                return 0;
+            }
+
+            n = recv(fd, p_buf+n_read, len-n_read, 0);
+        }
 
         //BTIF_TRACE_EVENT("read %d bytes", n);
 
@@ -841,11 +894,8 @@ UDRV_API extern BOOLEAN UIPC_Ioctl(tUIPC_CH_ID ch_id, UINT32 request, void *para
             /* user will read data directly and not use select loop */
             if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED)
             {
-                /* remove this channel from active set */
-                FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-
-                /* refresh active set */
-                uipc_wakeup_locked();
+                /* remove this channel from active set, takes effect right away */
+                uipc_del_fd_locked(uipc_main.ch[ch_id].fd);
             }
             break;
 